@@ -0,0 +1,150 @@
+#include "thorin/analyses/callgraph.h"
+
+#include <algorithm>
+
+#include "thorin/world.h"
+#include "thorin/analyses/scope.h"
+
+namespace thorin {
+
+CallGraph::CallGraph(World& world)
+    : world_(world)
+{
+    build();
+    tarjan();
+}
+
+CallGraph::Node* CallGraph::node(Continuation* continuation) {
+    auto i = continuation2node_.find(continuation);
+    if (i != continuation2node_.end())
+        return i->second;
+
+    auto n = owned_.emplace_back(std::make_unique<Node>(continuation, owned_.size())).get();
+    nodes_.emplace_back(n);
+    return continuation2node_[continuation] = n;
+}
+
+void CallGraph::build() {
+    unique_queue<ContinuationSet> continuation_queue;
+
+    for (auto continuation : world().exported_continuations())
+        continuation_queue.push(continuation);
+
+    while (!continuation_queue.empty()) {
+        auto continuation = continuation_queue.pop();
+        if (continuation->empty())
+            continue;
+
+        auto caller = node(continuation);
+        Scope scope(continuation);
+        unique_queue<DefSet> def_queue;
+        for (auto def : scope.free())
+            def_queue.push(def);
+
+        // walk through primops like Globals or Closures to find all referenced continuations
+        while (!def_queue.empty()) {
+            auto def = def_queue.pop();
+            if (auto callee = def->isa_continuation()) {
+                if (callee->empty())
+                    continue;
+                auto n = node(callee);
+                caller->callees_.emplace_back(n);
+                n->callers_.emplace_back(caller);
+                continuation_queue.push(callee);
+            } else {
+                for (auto op : def->ops())
+                    def_queue.push(op);
+            }
+        }
+    }
+}
+
+void CallGraph::tarjan() {
+    static const size_t undef = size_t(-1);
+    std::vector<size_t> dfs(size(), undef), low(size(), undef);
+    std::vector<bool> on_stack(size(), false);
+    std::vector<Node*> stack;
+    size_t number = 0;
+
+    // explicit DFS stack: node and index of the next callee to visit
+    std::vector<std::pair<Node*, size_t>> frames;
+
+    auto push = [&](Node* n) {
+        dfs[n->index()] = low[n->index()] = number++;
+        on_stack[n->index()] = true;
+        stack.emplace_back(n);
+        frames.emplace_back(n, 0);
+    };
+
+    for (auto& root : owned_) {
+        if (dfs[root->index()] != undef)
+            continue;
+
+        push(root.get());
+        while (!frames.empty()) {
+            auto n = frames.back().first;
+            auto i = frames.back().second++;
+
+            if (i != n->callees_.size()) {
+                auto callee = n->callees_[i];
+                if (dfs[callee->index()] == undef)
+                    push(owned_[callee->index()].get());
+                else if (on_stack[callee->index()])
+                    low[n->index()] = std::min(low[n->index()], dfs[callee->index()]);
+                continue;
+            }
+
+            frames.pop_back();
+            if (!frames.empty()) {
+                auto parent = frames.back().first;
+                low[parent->index()] = std::min(low[parent->index()], low[n->index()]);
+            }
+
+            if (low[n->index()] == dfs[n->index()]) {
+                auto& scc = sccs_.emplace_back();
+                Node* m;
+                do {
+                    m = stack.back();
+                    stack.pop_back();
+                    on_stack[m->index()] = false;
+                    m->scc_ = sccs_.size() - 1;
+                    scc.emplace_back(m);
+                } while (m != n);
+
+                for (auto member : scc) {
+                    auto self = std::find(member->callees_.begin(), member->callees_.end(), member) != member->callees_.end();
+                    owned_[member->index()]->recursive_ = scc.size() != 1 || self;
+                }
+            }
+        }
+    }
+}
+
+std::vector<const CallGraph::Node*> CallGraph::bottom_up() const {
+    std::vector<const Node*> result;
+    result.reserve(size());
+    for (const auto& scc : sccs_)
+        result.insert(result.end(), scc.begin(), scc.end());
+    return result;
+}
+
+std::vector<const CallGraph::Node*> CallGraph::top_down() const {
+    auto result = bottom_up();
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+Stream& CallGraph::stream(Stream& s) const {
+    s.fmt("call graph").indent();
+    for (const auto& scc : sccs_) {
+        s.endl().fmt("scc {}:", scc.front()->scc()).indent();
+        for (auto n : scc) {
+            s.endl().fmt("{}{} -> ", n->continuation(), n->is_recursive() ? " (recursive)" : "");
+            s.range(n->callees(), ", ", [&](const Node* callee) { s << callee->continuation(); });
+        }
+        s.dedent();
+    }
+    return s.dedent();
+}
+
+}
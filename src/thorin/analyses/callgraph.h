@@ -0,0 +1,84 @@
+#ifndef THORIN_ANALYSES_CALLGRAPH_H
+#define THORIN_ANALYSES_CALLGRAPH_H
+
+#include <memory>
+#include <vector>
+
+#include "thorin/continuation.h"
+#include "thorin/util/array.h"
+#include "thorin/util/stream.h"
+
+namespace thorin {
+
+/**
+ * The call graph of all @em top-level @p Continuation%s reachable from the exported ones (see @p Scope::for_each).
+ * There is an edge from @c f to @c g, if @c g is referenced from within the @p Scope of @c f.
+ * This comprises direct calls, calls through @p Global%s and bodies passed to intrinsics like @c cuda or @c parallel.
+ * Empty @p Continuation%s (imported functions and intrinsics) are not part of the graph.
+ * The strongly connected components are computed with Tarjan's algorithm.
+ */
+class CallGraph : public Streamable<CallGraph> {
+public:
+    class Node {
+    public:
+        Node(Continuation* continuation, size_t index)
+            : continuation_(continuation)
+            , index_(index)
+        {}
+
+        Continuation* continuation() const { return continuation_; }
+        /// Index of this @p Node within @p CallGraph::nodes().
+        size_t index() const { return index_; }
+        /// Index of this @p Node's strongly connected component within @p CallGraph::sccs().
+        size_t scc() const { return scc_; }
+        ArrayRef<const Node*> callees() const { return callees_; }
+        ArrayRef<const Node*> callers() const { return callers_; }
+        /// Is this @p Node part of a cycle, i.e. does it (indirectly) call itself?
+        bool is_recursive() const { return recursive_; }
+
+    private:
+        Continuation* continuation_;
+        size_t index_;
+        size_t scc_ = size_t(-1);
+        bool recursive_ = false;
+        std::vector<const Node*> callees_;
+        std::vector<const Node*> callers_;
+
+        friend class CallGraph;
+    };
+
+    CallGraph(const CallGraph&) = delete;
+    CallGraph& operator=(CallGraph) = delete;
+
+    explicit CallGraph(World&);
+
+    World& world() const { return world_; }
+    size_t size() const { return nodes_.size(); }
+    ArrayRef<const Node*> nodes() const { return nodes_; }
+    /// Returns @c nullptr if @p continuation is not a top-level @p Continuation of this @p CallGraph.
+    const Node* operator[](Continuation* continuation) const { auto i = continuation2node_.find(continuation); return i != continuation2node_.end() ? i->second : nullptr; }
+    /// Strongly connected components in bottom-up order: an SCC appears after all SCCs it calls.
+    const std::vector<std::vector<const Node*>>& sccs() const { return sccs_; }
+    /// All @p Node%s such that callees come before their callers (modulo recursion).
+    std::vector<const Node*> bottom_up() const;
+    /// All @p Node%s such that callers come before their callees (modulo recursion).
+    std::vector<const Node*> top_down() const;
+    bool is_recursive(Continuation* continuation) const { auto n = (*this)[continuation]; return n && n->is_recursive(); }
+
+    Stream& stream(Stream&) const;
+
+private:
+    Node* node(Continuation*);
+    void build();
+    void tarjan();
+
+    World& world_;
+    std::vector<const Node*> nodes_;
+    std::vector<std::unique_ptr<Node>> owned_;
+    ContinuationMap<Node*> continuation2node_;
+    std::vector<std::vector<const Node*>> sccs_;
+};
+
+}
+
+#endif
@@ -174,17 +174,21 @@ CFG<forward>::CFG(const CFA& cfa)
 
 template<bool forward>
 size_t CFG<forward>::post_order_visit(const CFNode* n, size_t i) {
-    auto& n_index = forward ? n->f_index_ : n->b_index_;
-    n_index = size_t(-2);
+    auto n_index = [](const CFNode* n) -> size_t& { return forward ? n->f_index_ : n->b_index_; };
 
-    for (auto succ : succs(n)) {
-        if (index(succ) == size_t(-1))
-            i = post_order_visit(succ, i);
-    }
-
-    n_index = i-1;
-    rpo_[n] = n;
-    return n_index;
+    post_order_walk(n,
+        [&](const CFNode* n) {
+            if (index(n) != size_t(-1)) return false;
+            n_index(n) = size_t(-2);
+            return true;
+        },
+        [&](const CFNode* n) -> const CFNodes& { return succs(n); },
+        [&](const CFNode* n) {
+            n_index(n) = --i;
+            rpo_[n] = n;
+        });
+
+    return index(n);
 }
 
 template<bool forward> const CFNodes& CFG<forward>::preds(const CFNode* n) const { assert(n != nullptr); return forward ? n->preds() : n->succs(); }
@@ -0,0 +1,77 @@
+#include "thorin/analyses/effect_regions.h"
+
+#include <numeric>
+
+#include "thorin/world.h"
+
+namespace thorin {
+
+EffectRegions::EffectRegions(const Scope& scope, bool restrict)
+    : scope_(scope)
+    , mssa_(scope)
+    , restrict_(restrict)
+{
+    run();
+}
+
+void EffectRegions::run() {
+    std::vector<const Def*> bases;
+    DefMap<size_t> base2index;
+    for (auto memop : mssa_.accesses()) {
+        if (auto access = memop->isa<Access>()) {
+            auto base = mssa_.ptr_info(access->ptr()).base;
+            if (base2index.emplace(base, bases.size()).second)
+                bases.push_back(base);
+        }
+    }
+
+    // union-find over all bases which may alias
+    std::vector<size_t> parent(bases.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    for (size_t i = 0, e = bases.size(); i != e; ++i) {
+        for (size_t j = i + 1; j != e; ++j) {
+            if (find(i) != find(j) && !is_disjoint(bases[i], bases[j]))
+                parent[find(j)] = find(i);
+        }
+    }
+
+    std::vector<size_t> root2region(bases.size(), size_t(-1));
+    DefMap<size_t> base2region;
+    for (size_t i = 0, e = bases.size(); i != e; ++i) {
+        auto& region = root2region[find(i)];
+        if (region == size_t(-1))
+            region = num_regions_++;
+        base2region[bases[i]] = region;
+    }
+
+    for (auto memop : mssa_.accesses()) {
+        if (auto access = memop->isa<Access>())
+            access2region_[access] = base2region[mssa_.ptr_info(access->ptr()).base];
+    }
+}
+
+size_t EffectRegions::region(const Access* access) const {
+    auto i = access2region_.find(access);
+    assert(i != access2region_.end() && "access not within this scope");
+    return i->second;
+}
+
+bool EffectRegions::is_restrict(const Def* base) const {
+    auto param = base->isa<Param>();
+    return restrict_ && param && param->continuation() == scope().entry() && param->type()->isa<PtrType>();
+}
+
+bool EffectRegions::is_disjoint(const Def* a, const Def* b) {
+    bool ra = is_restrict(a), rb = is_restrict(b);
+    if ((ra && (rb || MemorySSA::is_identified(b))) || (rb && MemorySSA::is_identified(a)))
+        return true;
+    return mssa_.alias(a, b) == AliasResult::No;
+}
+
+}
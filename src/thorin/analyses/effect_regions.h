@@ -0,0 +1,42 @@
+#ifndef THORIN_ANALYSES_EFFECT_REGIONS_H
+#define THORIN_ANALYSES_EFFECT_REGIONS_H
+
+#include "thorin/analyses/memory_ssa.h"
+
+namespace thorin {
+
+/**
+ * Partitions the @p Load%s and @p Store%s within a @p Scope into regions of memory which are disjoint from each other.
+ * Accesses whose bases (see @p PtrInfo) may alias end up in the same region.
+ * Thus, distinct @p Slot%s, @p Global%s and non-escaping @p Alloc%s get regions of their own whereas all unidentified pointers share one.
+ * If @p restrict is set, the pointer @p Param%s of the @p Scope's entry point to distinct objects - as the @c restrict pointers of a kernel do.
+ */
+class EffectRegions {
+public:
+    EffectRegions(const EffectRegions&) = delete;
+    EffectRegions& operator=(EffectRegions) = delete;
+
+    explicit EffectRegions(const Scope&, bool restrict = false);
+
+    const Scope& scope() const { return scope_; }
+    World& world() const { return scope_.world(); }
+    MemorySSA& mssa() { return mssa_; }
+    size_t num_regions() const { return num_regions_; }
+    /// The region of @p access - in <tt>[0, num_regions())</tt>.
+    size_t region(const Access* access) const;
+
+private:
+    void run();
+    bool is_restrict(const Def* base) const;
+    bool is_disjoint(const Def* a, const Def* b);
+
+    const Scope& scope_;
+    MemorySSA mssa_;
+    bool restrict_;
+    DefMap<size_t> access2region_;
+    size_t num_regions_ = 0;
+};
+
+}
+
+#endif
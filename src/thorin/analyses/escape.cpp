@@ -0,0 +1,53 @@
+#include "thorin/analyses/escape.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+
+namespace thorin {
+
+bool escapes(const Def* ptr) {
+    unique_queue<DefSet> queue;
+    queue.push(ptr);
+    while (!queue.empty()) {
+        auto def = queue.pop();
+        for (auto use : def->uses()) {
+            if ((use->isa<LEA>() || use->isa<Bitcast>()) && use.index() == 0) {
+                queue.push(use.def());
+                continue;
+            }
+            if ((use->isa<Load>() || use->isa<Store>()) && use.index() == 1)
+                continue;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Is @p param only used as callee?
+static bool is_only_called(const Param* param) {
+    for (auto use : param->uses()) {
+        if (!use->isa_continuation() || use.index() != 0)
+            return false;
+    }
+    return true;
+}
+
+bool escapes(const Closure* closure) {
+    for (auto use : closure->uses()) {
+        auto continuation = use->isa_continuation();
+        if (continuation == nullptr)
+            return true;
+        if (use.index() == 0)
+            continue;
+
+        // passed as argument: the callee must be known and must only call the closure
+        auto callee = continuation->callee()->isa_continuation();
+        if (callee == nullptr || callee->empty() || callee->is_exported() || callee->is_intrinsic())
+            return true;
+        if (!is_only_called(callee->param(use.index() - 1)))
+            return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,25 @@
+#ifndef THORIN_ANALYSES_ESCAPE_H
+#define THORIN_ANALYSES_ESCAPE_H
+
+namespace thorin {
+
+class Closure;
+class Def;
+
+/**
+ * Does the memory @p ptr points to escape?
+ * This is the case if @p ptr - or any pointer derived from it via @p LEA or @p Bitcast - is used by anything but @p Load%s and @p Store%s to it.
+ * Thus, a non-escaping object is only accessible within the @p Scope which computes @p ptr, and dies with it.
+ */
+bool escapes(const Def* ptr);
+
+/**
+ * Does @p closure escape the frame of the function which creates it?
+ * A @p closure does not escape, if it is only called or passed to a function which in turn only calls the respective parameter.
+ * In this case, its environment may live in the creator's stack frame.
+ */
+bool escapes(const Closure* closure);
+
+}
+
+#endif
@@ -0,0 +1,272 @@
+#include "thorin/analyses/induction.h"
+
+#include <functional>
+
+#include "thorin/world.h"
+#include "thorin/analyses/value_range.h"
+
+namespace thorin {
+
+/// Trip counts are only computed for values of at most this magnitude to stay clear of overflows.
+static const int64_t max_trip_value = int64_t(1) << 62;
+
+InductionVars::InductionVars(const Scope& scope)
+    : scope_(scope)
+    , cfg_(scope.f_cfg())
+{
+    run();
+}
+
+void InductionVars::run() {
+    // innermost loops first
+    std::function<void(const LoopTree<true>::Base*)> visit = [&](const LoopTree<true>::Base* n) {
+        if (auto head = n->isa<LoopTree<true>::Head>()) {
+            for (const auto& child : head->children())
+                visit(child.get());
+            if (!head->is_root())
+                analyze(head);
+        }
+    };
+    visit(cfg_.looptree().root());
+}
+
+const InductionVars::Loop* InductionVars::loop(Continuation* header) const {
+    auto i = header2loop_.find(header);
+    return i != header2loop_.end() ? &loops_[i->second] : nullptr;
+}
+
+const InductionVar* InductionVars::iv(const Param* param) const {
+    auto i = param2iv_.find(param);
+    return i != param2iv_.end() ? &loops_[i->second.first].ivs[i->second.second] : nullptr;
+}
+
+bool InductionVars::contains(const Loop& loop, Continuation* continuation) const {
+    auto n = cfg_[continuation];
+    if (n == nullptr)
+        return false;
+    for (const LoopTree<true>::Base* i = cfg_.looptree()[n]; i != nullptr; i = i->parent()) {
+        if (i == loop.head)
+            return true;
+    }
+    return false;
+}
+
+void InductionVars::analyze(const LoopTree<true>::Head* head) {
+    if (head->num_cf_nodes() != 1)
+        return; // multiple entries
+
+    auto header = head->cf_nodes().front()->continuation();
+    if (header->num_params() == 0)
+        return;
+
+    Loop candidate;
+    candidate.head   = head;
+    candidate.header = header;
+
+    // the header must only be jumped to
+    for (auto use : header->uses()) {
+        auto caller = use->isa_continuation();
+        if (caller == nullptr || use.index() != 0 || !scope().contains(caller))
+            return;
+        (contains(candidate, caller) ? candidate.latches : candidate.preheaders).push_back(caller);
+    }
+    if (candidate.preheaders.empty() || candidate.latches.empty())
+        return;
+
+    auto index = loops_.size();
+    header2loop_[header] = index;
+    loops_.push_back(std::move(candidate));
+    invariant_.emplace_back();
+    auto& loop = loops_.back();
+
+    for (auto param : header->params()) {
+        if (!is_type_i(param->type()))
+            continue;
+
+        // all latches must pass param + step with the same loop-invariant step
+        const Def* step = nullptr;
+        for (auto latch : loop.latches) {
+            auto next = latch->arg(param->index())->isa<ArithOp>();
+            const Def* s = nullptr;
+            if (next && next->arithop_tag() == ArithOp_add) {
+                if (next->lhs() == param) s = next->rhs();
+                else if (next->rhs() == param) s = next->lhs();
+            } else if (next && next->arithop_tag() == ArithOp_sub && next->lhs() == param) {
+                s = world().arithop_minus(next->rhs());
+            }
+
+            if (s == nullptr || (step != nullptr && s != step) || !is_invariant(loop, s)) {
+                step = nullptr;
+                break;
+            }
+            step = s;
+        }
+        if (step == nullptr)
+            continue;
+
+        // all preheaders must agree on the initial value
+        const Def* init = loop.preheaders.front()->arg(param->index());
+        for (auto preheader : loop.preheaders) {
+            if (preheader->arg(param->index()) != init)
+                init = nullptr;
+        }
+        if (init == nullptr)
+            continue;
+
+        param2iv_[param] = {index, loop.ivs.size()};
+        loop.ivs.push_back({param, init, step});
+    }
+
+    auto callee = header->callee()->isa_continuation();
+    if (callee && callee->intrinsic() == Intrinsic::Branch) {
+        auto t = header->arg(1)->as_continuation(), f = header->arg(2)->as_continuation();
+        if (contains(loop, t) != contains(loop, f)) {
+            loop.body = contains(loop, t) ? t : f;
+            loop.exit = contains(loop, t) ? f : t;
+            loop.exits_at_header = true;
+            for (auto n : cfg_.reverse_post_order()) {
+                if (n->continuation() == header || !contains(loop, n->continuation()))
+                    continue;
+                for (auto succ : cfg_.succs(n))
+                    loop.exits_at_header &= contains(loop, succ->continuation());
+            }
+        }
+    }
+
+    const InductionVar* counter = nullptr;
+    loop.trip_count = trip_count(loop, counter);
+    if (loop.trip_count)
+        loop.counter = counter->param;
+}
+
+bool InductionVars::is_invariant(const Loop& loop, const Def* def) {
+    auto index = header2loop_.find(loop.header)->second;
+    if (auto i = invariant_[index].find(def); i != invariant_[index].end())
+        return i->second;
+
+    bool result;
+    if (def->isa<Literal>() || def->isa<Global>())
+        result = true;
+    else if (auto param = def->isa<Param>())
+        result = !contains(loop, param->continuation());
+    else if (auto continuation = def->isa_continuation())
+        result = !contains(loop, continuation);
+    else {
+        result = true;
+        for (auto op : def->ops()) {
+            if (!is_invariant(loop, op)) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    return invariant_[index][def] = result;
+}
+
+std::optional<Affine> InductionVars::affine(const Loop& loop, const Def* def) {
+    if (auto param = def->isa<Param>()) {
+        if (auto iv = this->iv(param); iv && loop.header == param->continuation())
+            return Affine{iv, world().one(def->type()), world().zero(def->type())};
+        return std::nullopt;
+    }
+
+    auto arithop = def->isa<ArithOp>();
+    if (arithop == nullptr || !is_type_i(def->type()))
+        return std::nullopt;
+
+    auto lhs = arithop->lhs(), rhs = arithop->rhs();
+    switch (arithop->arithop_tag()) {
+        case ArithOp_add:
+        case ArithOp_sub: {
+            bool add = arithop->arithop_tag() == ArithOp_add;
+            auto a = affine(loop, lhs), b = affine(loop, rhs);
+            if (a && b) {
+                if (a->iv != b->iv)
+                    return std::nullopt;
+                return Affine{a->iv, world().arithop(arithop->arithop_tag(), a->scale,  b->scale),
+                                     world().arithop(arithop->arithop_tag(), a->offset, b->offset)};
+            }
+            if (a && is_invariant(loop, rhs))
+                return Affine{a->iv, a->scale, world().arithop(arithop->arithop_tag(), a->offset, rhs)};
+            if (b && is_invariant(loop, lhs)) {
+                auto scale = add ? b->scale : world().arithop_minus(b->scale);
+                return Affine{b->iv, scale, world().arithop(arithop->arithop_tag(), lhs, b->offset)};
+            }
+            return std::nullopt;
+        }
+        case ArithOp_mul: {
+            if (auto a = affine(loop, lhs); a && is_invariant(loop, rhs))
+                return Affine{a->iv, world().arithop_mul(a->scale, rhs), world().arithop_mul(a->offset, rhs)};
+            if (auto b = affine(loop, rhs); b && is_invariant(loop, lhs))
+                return Affine{b->iv, world().arithop_mul(lhs, b->scale), world().arithop_mul(lhs, b->offset)};
+            return std::nullopt;
+        }
+        case ArithOp_shl: {
+            if (auto a = affine(loop, lhs); a && is_invariant(loop, rhs))
+                return Affine{a->iv, world().arithop_shl(a->scale, rhs), world().arithop_shl(a->offset, rhs)};
+            return std::nullopt;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<uint64_t> InductionVars::trip_count(const Loop& loop, const InductionVar*& counter) {
+    if (!loop.exits_at_header)
+        return std::nullopt;
+
+    auto cmp = loop.header->arg(0)->isa<Cmp>();
+    if (cmp == nullptr)
+        return std::nullopt;
+
+    auto tag = loop.body == loop.header->arg(1) ? cmp->cmp_tag() : negate(cmp->cmp_tag());
+    auto lhs = cmp->lhs(), rhs = cmp->rhs();
+    auto iv = lhs->isa<Param>() ? this->iv(lhs->as<Param>()) : nullptr;
+    if (iv == nullptr || iv->param->continuation() != loop.header) {
+        iv = rhs->isa<Param>() ? this->iv(rhs->as<Param>()) : nullptr;
+        if (iv == nullptr || iv->param->continuation() != loop.header)
+            return std::nullopt;
+        std::swap(lhs, rhs);
+        switch (tag) {
+            case Cmp_lt: tag = Cmp_gt; break;
+            case Cmp_le: tag = Cmp_ge; break;
+            case Cmp_gt: tag = Cmp_lt; break;
+            case Cmp_ge: tag = Cmp_le; break;
+            default: break;
+        }
+    }
+
+    counter = iv;
+    if (!iv->init->isa<PrimLit>() || !iv->step->isa<PrimLit>() || !rhs->isa<PrimLit>())
+        return std::nullopt;
+
+    auto type = iv->param->type();
+    auto value = [&](const Def* def) { return is_type_s(type) ? primlit_value<int64_t>(def) : int64_t(primlit_value<uint64_t>(def)); };
+    int64_t init = value(iv->init), step = value(iv->step), bound = value(rhs);
+    for (auto v : {init, step, bound}) {
+        if (v < -max_trip_value || v > max_trip_value)
+            return std::nullopt;
+    }
+
+    // the induction variable must not wrap around before the loop exits
+    auto limits = type_range(type);
+    if (!Interval(bound + step, bound + step).within(limits.lo, limits.hi) || !Interval(init, init).within(limits.lo, limits.hi))
+        return std::nullopt;
+
+    switch (tag) {
+        case Cmp_lt: if (step > 0) return init < bound ? uint64_t((bound - init + step - 1) / step) : 0; break;
+        case Cmp_le: if (step > 0) return init <= bound ? uint64_t((bound - init) / step + 1) : 0; break;
+        case Cmp_gt: if (step < 0) return init > bound ? uint64_t((init - bound - step - 1) / -step) : 0; break;
+        case Cmp_ge: if (step < 0) return init >= bound ? uint64_t((init - bound) / -step + 1) : 0; break;
+        case Cmp_ne:
+            if (step != 0 && (bound - init) % step == 0 && (bound - init) / step >= 0)
+                return uint64_t((bound - init) / step);
+            break;
+        default:
+            break;
+    }
+    return std::nullopt;
+}
+
+}
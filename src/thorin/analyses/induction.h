@@ -0,0 +1,86 @@
+#ifndef THORIN_ANALYSES_INDUCTION_H
+#define THORIN_ANALYSES_INDUCTION_H
+
+#include <optional>
+#include <vector>
+
+#include "thorin/primop.h"
+#include "thorin/analyses/cfg.h"
+#include "thorin/analyses/looptree.h"
+
+namespace thorin {
+
+/// A basic induction variable: a @p param of a loop header which is @p init on entry and incremented by the loop-invariant @p step on each back edge.
+struct InductionVar {
+    const Param* param;
+    const Def* init;
+    const Def* step;
+};
+
+/// The value <tt>scale * iv + offset</tt> with loop-invariant @p scale and @p offset.
+struct Affine {
+    const InductionVar* iv;
+    const Def* scale;
+    const Def* offset;
+};
+
+/**
+ * Finds the loops within a @p Scope that are entered via a single header only - as produced by lower2cff - and their @p InductionVar%s.
+ * Such a header must only be jumped to: from outside the loop via its preheaders and from inside via its latches.
+ * If the header exits the loop via a @c branch on an @p InductionVar compared to a loop-invariant bound, the trip count is known.
+ */
+class InductionVars {
+public:
+    struct Loop {
+        const LoopTree<true>::Head* head;
+        Continuation* header;
+        std::vector<Continuation*> preheaders;
+        std::vector<Continuation*> latches;
+        std::vector<InductionVar> ivs;
+        /// Continuation of the header's @c branch that stays in the loop - @c nullptr if the header does not exit the loop.
+        Continuation* body = nullptr;
+        /// Continuation of the header's @c branch that leaves the loop.
+        Continuation* exit = nullptr;
+        /// Is the header's @c branch to @p exit the only way out of the loop?
+        bool exits_at_header = false;
+        /// Number of times @p body is executed per entry of the loop - if known at compile time.
+        std::optional<uint64_t> trip_count;
+        /// The @p InductionVar%'s @p Param compared in the exit test - set iff @p trip_count is.
+        const Param* counter = nullptr;
+    };
+
+    InductionVars(const InductionVars&) = delete;
+    InductionVars& operator=(InductionVars) = delete;
+
+    explicit InductionVars(const Scope&);
+
+    const Scope& scope() const { return scope_; }
+    World& world() const { return scope_.world(); }
+    const F_CFG& cfg() const { return cfg_; }
+    /// All loops found - innermost first.
+    const std::vector<Loop>& loops() const { return loops_; }
+    const Loop* loop(Continuation* header) const;
+    const InductionVar* iv(const Param* param) const;
+    /// Is @p continuation part of @p loop?
+    bool contains(const Loop& loop, Continuation* continuation) const;
+    /// Does @p def compute the same value in each iteration of @p loop?
+    bool is_invariant(const Loop& loop, const Def* def);
+    /// Decomposes @p def into an @p Affine function of an @p InductionVar of @p loop; may create new nodes for @c scale and @c offset.
+    std::optional<Affine> affine(const Loop& loop, const Def* def);
+
+private:
+    void run();
+    void analyze(const LoopTree<true>::Head*);
+    std::optional<uint64_t> trip_count(const Loop&, const InductionVar*& counter);
+
+    const Scope& scope_;
+    const F_CFG& cfg_;
+    std::vector<Loop> loops_;
+    ParamMap<std::pair<size_t, size_t>> param2iv_; ///< Index of the loop and of the induction variable within.
+    ContinuationMap<size_t> header2loop_;
+    std::vector<DefMap<bool>> invariant_;          ///< Per loop.
+};
+
+}
+
+#endif
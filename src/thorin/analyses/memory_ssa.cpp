@@ -0,0 +1,297 @@
+#include "thorin/analyses/memory_ssa.h"
+
+#include <algorithm>
+
+#include "thorin/world.h"
+#include "thorin/analyses/cfg.h"
+#include "thorin/analyses/escape.h"
+
+namespace thorin {
+
+MemorySSA::MemorySSA(const Scope& scope)
+    : scope_(scope)
+{
+    run();
+}
+
+void MemorySSA::run() {
+    for (auto def : scope().defs()) {
+        if (auto memop = def->isa<MemOp>())
+            accesses_.emplace_back(memop);
+    }
+    std::sort(accesses_.begin(), accesses_.end(), [](const MemOp* a, const MemOp* b) { return a->gid() < b->gid(); });
+
+    if (auto mem = scope().entry()->mem_param())
+        param2kind_[mem] = ParamKind::Entry;
+
+    for (auto n : scope().f_cfg().reverse_post_order()) {
+        auto continuation = n->continuation();
+        if (continuation->empty())
+            continue;
+
+        auto callee = continuation->callee()->isa_continuation();
+        bool jump = callee && scope().contains(callee) && !callee->is_intrinsic();
+
+        for (size_t i = 0, e = continuation->num_args(); i != e; ++i) {
+            auto arg = continuation->arg(i);
+            if (jump && is_mem(arg)) {
+                auto param = callee->param(i);
+                param2kind_.emplace(param, ParamKind::Phi);
+                incoming_[param].emplace_back(arg);
+            } else if (auto cont = arg->isa_continuation(); !jump && cont && scope().contains(cont)) {
+                // cont is invoked by someone else - e.g. as return continuation or as body of an intrinsic
+                if (auto mem = cont->mem_param()) {
+                    auto& kind = param2kind_.emplace(mem, ParamKind::Call).first->second;
+                    if (kind == ParamKind::Phi)
+                        kind = ParamKind::Call; // conservative: memory may come from the call as well
+                    calls_[mem].emplace_back(continuation);
+                }
+            }
+        }
+    }
+
+    // phis which also receive the result of a call are treated as call results
+    for (auto& [param, kind] : param2kind_) {
+        if (kind == ParamKind::Call)
+            incoming_.erase(param);
+    }
+}
+
+const Def* MemorySSA::access(const Def* mem) {
+    if (auto extract = mem->isa<Extract>()) {
+        if (auto memop = extract->agg()->isa<MemOp>(); memop && is_primlit(extract->index(), 0))
+            return memop;
+    }
+    return mem;
+}
+
+const Def* MemorySSA::out_mem(const Def* access) {
+    if (!access->isa<MemOp>() || !access->as<MemOp>()->has_multiple_outs())
+        return access;
+
+    for (auto use : access->uses()) {
+        if (auto extract = use->isa<Extract>(); extract && is_primlit(extract->index(), 0))
+            return extract;
+    }
+    return nullptr;
+}
+
+ArrayRef<const Def*> MemorySSA::incoming(const Param* param) const {
+    auto i = incoming_.find(param);
+    return i != incoming_.end() ? ArrayRef<const Def*>(i->second) : ArrayRef<const Def*>();
+}
+
+ArrayRef<Continuation*> MemorySSA::calls(const Param* param) const {
+    auto i = calls_.find(param);
+    return i != calls_.end() ? ArrayRef<Continuation*>(i->second) : ArrayRef<Continuation*>();
+}
+
+std::vector<MemorySSA::User> MemorySSA::users(const Def* mem) const {
+    std::vector<User> result;
+    for (auto use : mem->uses()) {
+        auto def = use.def();
+        if (auto memop = def->isa<MemOp>(); memop && use.index() == 0) {
+            result.push_back({User::Access, memop, nullptr, nullptr});
+        } else if (auto continuation = def->isa_continuation(); continuation && use.index() != 0 && scope().contains(continuation)) {
+            auto callee = continuation->callee()->isa_continuation();
+            if (callee && scope().contains(callee) && !callee->is_intrinsic()) {
+                result.push_back({User::Jump, def, continuation, callee->param(use.index() - 1)});
+                continue;
+            }
+
+            // look for the continuation which receives the memory after the call
+            const Param* param = nullptr;
+            for (auto arg : continuation->args()) {
+                if (auto cont = arg->isa_continuation(); cont && scope().contains(cont) && cont->mem_param()) {
+                    param = cont->mem_param();
+                    break;
+                }
+            }
+            result.push_back({param != nullptr ? User::Call : User::Exit, def, continuation, param});
+        } else {
+            result.push_back({User::Unknown, def, nullptr, nullptr});
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+static bool is_exact_bitcast(const Bitcast* bitcast) {
+    auto to   = bitcast->type()->isa<PtrType>();
+    auto from = bitcast->from()->type()->isa<PtrType>();
+    if (!to || !from)
+        return false;
+    // only the address space changes
+    if (to->pointee() == from->pointee())
+        return true;
+    // pointer to definite array to pointer to indefinite array with the same element type
+    auto array_to   = to  ->pointee()->isa<IndefiniteArrayType>();
+    auto array_from = from->pointee()->isa<DefiniteArrayType>();
+    return array_to && array_from && array_to->elem_type() == array_from->elem_type();
+}
+
+const PtrInfo& MemorySSA::ptr_info(const Def* ptr) {
+    if (auto i = ptr_infos_.find(ptr); i != ptr_infos_.end())
+        return i->second;
+
+    PtrInfo info;
+    auto cur = ptr;
+    while (true) {
+        if (auto bitcast = cur->isa<Bitcast>()) {
+            info.exact &= is_exact_bitcast(bitcast);
+            cur = bitcast->from();
+        } else if (auto lea = cur->isa<LEA>()) {
+            info.path.emplace_back(lea->index());
+            cur = lea->ptr();
+        } else {
+            break;
+        }
+    }
+    std::reverse(info.path.begin(), info.path.end());
+    info.base = cur;
+    return ptr_infos_[ptr] = std::move(info);
+}
+
+bool MemorySSA::is_identified(const Def* base) {
+    return base->isa<Slot>() || base->isa<Global>() || Alloc::is_out_ptr(base);
+}
+
+bool MemorySSA::escapes(const Def* base) {
+    if (auto i = escapes_.find(base); i != escapes_.end())
+        return i->second;
+
+    if (!is_identified(base) || base->isa<Global>())
+        return escapes_[base] = true;
+
+    return escapes_[base] = thorin::escapes(base);
+}
+
+AliasResult MemorySSA::alias(const Def* a, const Def* b) {
+    if (a == b)
+        return AliasResult::Must;
+
+    auto pa = ptr_info(a); // copy - the lookup of b may rehash
+    const auto& pb = ptr_info(b);
+
+    if (pa.base == pb.base) {
+        if (!pa.exact || !pb.exact)
+            return AliasResult::May;
+
+        auto n = std::min(pa.path.size(), pb.path.size());
+        bool same = true;
+        for (size_t i = 0; i != n; ++i) {
+            auto ia = pa.path[i], ib = pb.path[i];
+            if (ia == ib)
+                continue;
+            auto la = ia->isa<PrimLit>(), lb = ib->isa<PrimLit>();
+            if (la && lb && la->value().get_u64() != lb->value().get_u64())
+                return AliasResult::No;
+            same = false;
+        }
+
+        return same && pa.path.size() == pb.path.size() ? AliasResult::Must : AliasResult::May;
+    }
+
+    bool ia = is_identified(pa.base), ib = is_identified(pb.base);
+    if (ia && ib)
+        return AliasResult::No;
+    // a non-escaping object can only be reached via its base
+    if ((ia && !escapes(pa.base)) || (ib && !escapes(pb.base)))
+        return AliasResult::No;
+
+    return AliasResult::May;
+}
+
+bool MemorySSA::has_literal_path(const Def* ptr) {
+    const auto& path = ptr_info(ptr).path;
+    return std::all_of(path.begin(), path.end(), [] (const Def* def) { return def->isa<PrimLit>(); });
+}
+
+bool MemorySSA::call_may_clobber(const Def* ptr) {
+    auto base = ptr_info(ptr).base;
+    if (auto global = base->isa<Global>())
+        return global->is_mutable();
+    return escapes(base);
+}
+
+//------------------------------------------------------------------------------
+
+bool MemorySSA::may_clobber(const Def* access, const Def* ptr) {
+    if (auto store = access->isa<Store>())
+        return alias(store->ptr(), ptr) != AliasResult::No;
+
+    const auto& info = ptr_info(ptr);
+    if (auto enter = access->isa<Enter>()) {
+        // the memory of a slot comes into being here
+        auto slot = info.base->isa<Slot>();
+        return slot && Enter::is_out_frame(slot->frame()) == enter;
+    }
+    if (auto alloc = access->isa<Alloc>())
+        return Alloc::is_out_ptr(info.base) == alloc;
+    if (access->isa<Load>() || access->isa<Join>())
+        return false;
+    if (auto param = access->isa<Param>()) {
+        switch (kind(param)) {
+            case ParamKind::Phi:  return false;
+            case ParamKind::Call: return call_may_clobber(ptr);
+            default:              return true;
+        }
+    }
+    return true; // Assembly or anything unknown
+}
+
+const Def* MemorySSA::clobber(const Def* mem, const Def* ptr) {
+    std::vector<const Def*> stack;
+    DefSet done;
+    DefSet clobbers;
+    const Param* first_phi = nullptr;
+
+    auto push = [&](const Def* mem) {
+        auto acc = access(mem);
+        if (done.emplace(acc).second)
+            stack.emplace_back(acc);
+    };
+
+    push(mem);
+    while (!stack.empty()) {
+        auto acc = stack.back();
+        stack.pop_back();
+
+        if (may_clobber(acc, ptr)) {
+            clobbers.emplace(acc);
+            continue;
+        }
+
+        if (auto join = acc->isa<Join>()) {
+            for (auto in : join->mems())
+                push(in);
+        } else if (auto memop = acc->isa<MemOp>()) {
+            push(memop->mem());
+        } else if (auto param = acc->isa<Param>()) {
+            if (kind(param) == ParamKind::Phi) {
+                if (first_phi == nullptr && clobbers.empty() && stack.empty())
+                    first_phi = param;
+                for (auto in : incoming(param))
+                    push(in);
+            } else {
+                // a call which does not touch ptr
+                assert(kind(param) == ParamKind::Call);
+                for (auto call : calls(param)) {
+                    for (auto arg : call->args()) {
+                        if (is_mem(arg))
+                            push(arg);
+                    }
+                }
+            }
+        } else {
+            clobbers.emplace(acc);
+        }
+    }
+
+    if (clobbers.size() == 1)
+        return *clobbers.begin();
+    return first_phi != nullptr ? first_phi : access(mem);
+}
+
+}
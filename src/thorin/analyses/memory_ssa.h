@@ -0,0 +1,125 @@
+#ifndef THORIN_ANALYSES_MEMORY_SSA_H
+#define THORIN_ANALYSES_MEMORY_SSA_H
+
+#include <vector>
+
+#include "thorin/primop.h"
+#include "thorin/analyses/scope.h"
+
+namespace thorin {
+
+/// Decomposes a pointer into the object it points into and the path of @p LEA indices leading to it.
+struct PtrInfo {
+    /// A @p Slot, a @p Global, the pointer returned by an @p Alloc or any other @p Def that produces the pointer.
+    const Def* base = nullptr;
+    /// @p LEA indices from @p base to the pointer, outermost first.
+    std::vector<const Def*> path;
+    /// @c false if the pointer passes through a @p Bitcast that reinterprets the memory.
+    bool exact = true;
+};
+
+enum class AliasResult { No, May, Must };
+
+/**
+ * A MemorySSA-style view of the memory chains within a @p Scope.
+ * In Thorin, memory already is in SSA form: each @p MemOp consumes a @c mem and produces a new one.
+ * Memory flows across @p Continuation%s via @c mem @p Param%s which act as phis.
+ * Such a @p Param is either
+ *  - the @c mem of the @p Scope's entry (live on entry),
+ *  - a phi whose incoming memory states are the @c mem arguments of all jumps to its @p Continuation, or
+ *  - the result of a call to a function or intrinsic which received the @p Param's @p Continuation as argument.
+ * A @p Join merges the states of independent chains as built by @p split_effects.
+ *
+ * On top of this, @p clobber answers which access last wrote to a pointer, based on a pointer-base analysis through @p LEA and @p Bitcast.
+ */
+class MemorySSA {
+public:
+    enum class ParamKind { None, Entry, Phi, Call };
+
+    /// Consumer of a memory state.
+    struct User {
+        enum Kind {
+            Access,  ///< A @p MemOp in @p def.
+            Jump,    ///< A jump from @p continuation to a @p Continuation within the @p Scope; the state flows into @p param.
+            Call,    ///< A call from @p continuation to a function or intrinsic; the result flows into @p param - if any.
+            Exit,    ///< A jump from @p continuation that leaves the @p Scope, e.g. a return.
+            Unknown  ///< Any other use in @p def.
+        };
+
+        Kind kind;
+        const Def* def;
+        Continuation* continuation;
+        const Param* param;
+    };
+
+    MemorySSA(const MemorySSA&) = delete;
+    MemorySSA& operator=(MemorySSA) = delete;
+
+    explicit MemorySSA(const Scope&);
+
+    const Scope& scope() const { return scope_; }
+    World& world() const { return scope_.world(); }
+    /// All @p MemOp%s within the @p Scope.
+    const std::vector<const MemOp*>& accesses() const { return accesses_; }
+
+    /// @name memory states
+    //@{
+    /// The access which produces the memory state @p mem: a @p MemOp or a @c mem @p Param.
+    static const Def* access(const Def* mem);
+    /// The memory state produced by @p access without creating new nodes - @c nullptr, if unused.
+    static const Def* out_mem(const Def* access);
+    ParamKind kind(const Param* param) const { auto i = param2kind_.find(param); return i != param2kind_.end() ? i->second : ParamKind::None; }
+    /// Memory states flowing into the phi @p param.
+    ArrayRef<const Def*> incoming(const Param* param) const;
+    /// The call sites whose result flows into @p param.
+    ArrayRef<Continuation*> calls(const Param* param) const;
+    /// All consumers of the memory state @p mem.
+    std::vector<User> users(const Def* mem) const;
+    //@}
+
+    /// @name pointer analysis
+    //@{
+    const PtrInfo& ptr_info(const Def* ptr);
+    /// Is @p base a @p Slot, a @p Global or the pointer returned by an @p Alloc?
+    static bool is_identified(const Def* base);
+    /// Is the object at @p base accessible by anything but @p Load%s and @p Store%s within this @p Scope?
+    bool escapes(const Def* base);
+    /**
+     * @p AliasResult::Must only holds for a single evaluation of @p a and @p b - that is, for the same values of the @p Param%s they depend on.
+     * A walk along the memory chain that wraps around a loop must not rely on it unless @p has_literal_path:
+     * The very same <tt>lea(a, i)</tt> addresses another element in the next iteration, if @c i is a @p Param of the loop header.
+     */
+    AliasResult alias(const Def* a, const Def* b);
+    /// Are all indices from the base to @p ptr literals?
+    bool has_literal_path(const Def* ptr);
+    /// May a call to an unknown function write to @p ptr?
+    bool call_may_clobber(const Def* ptr);
+    //@}
+
+    /// @name clobber queries
+    //@{
+    /// May @p access write to the memory @p ptr points to?
+    bool may_clobber(const Def* access, const Def* ptr);
+    /**
+     * Walks the memory chain upwards starting at the state @p mem and returns the nearest access that may write to @p ptr.
+     * If different accesses clobber @p ptr on different paths, the first phi on the way up is returned.
+     * The result is either a @p MemOp or a @c mem @p Param.
+     */
+    const Def* clobber(const Def* mem, const Def* ptr);
+    //@}
+
+private:
+    void run();
+
+    const Scope& scope_;
+    std::vector<const MemOp*> accesses_;
+    ParamMap<ParamKind> param2kind_;
+    ParamMap<std::vector<const Def*>> incoming_;
+    ParamMap<std::vector<Continuation*>> calls_;
+    DefMap<PtrInfo> ptr_infos_;
+    DefMap<bool> escapes_;
+};
+
+}
+
+#endif
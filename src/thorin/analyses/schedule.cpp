@@ -46,36 +46,60 @@ Scheduler::Scheduler(const Scope& s)
 
 Continuation* Scheduler::early(const Def* def) {
     if (auto cont = early_.lookup(def)) return *cont;
-    if (auto param = def->isa<Param>()) return early_[def] = param->continuation();
-
-    auto result = scope().entry();
-    for (auto op : def->as<PrimOp>()->ops()) {
-        if (!op->isa_continuation() && def2uses_.find(op) != def2uses_.end()) {
-            auto cont = early(op);
-            if (domtree().depth(cfg(cont)) > domtree().depth(cfg(result)))
-                result = cont;
-        }
-    }
 
-    return early_[def] = result;
+    auto is_scheduled = [&](const Def* op) { return !op->isa_continuation() && def2uses_.find(op) != def2uses_.end(); };
+
+    post_order_walk(def,
+        [&](const Def* n) {
+            if (early_.contains(n) || (n != def && !is_scheduled(n))) return false;
+            if (auto param = n->isa<Param>()) {
+                early_[n] = param->continuation();
+                return false;
+            }
+            return true;
+        },
+        [&](const Def* n) { return n->ops(); },
+        [&](const Def* n) {
+            auto result = scope().entry();
+            for (auto op : n->as<PrimOp>()->ops()) {
+                if (is_scheduled(op)) {
+                    auto cont = early_[op];
+                    if (domtree().depth(cfg(cont)) > domtree().depth(cfg(result)))
+                        result = cont;
+                }
+            }
+            early_[n] = result;
+        });
+
+    return early_[def];
 }
 
 Continuation* Scheduler::late(const Def* def) {
     if (auto cont = late_.lookup(def)) return *cont;
 
-    Continuation* result = nullptr;
-    if (auto continuation = def->isa_continuation()) {
-        result = continuation;
-    } else if (auto param = def->isa<Param>()) {
-        result = param->continuation();
-    } else {
-        for (auto use : uses(def)) {
-            auto cont = late(use);
-            result = result ? domtree().least_common_ancestor(cfg(result), cfg(cont))->continuation() : cont;
-        }
-    }
+    post_order_walk(def,
+        [&](const Def* n) {
+            if (late_.contains(n)) return false;
+            if (auto continuation = n->isa_continuation()) {
+                late_[n] = continuation;
+                return false;
+            } else if (auto param = n->isa<Param>()) {
+                late_[n] = param->continuation();
+                return false;
+            }
+            return true;
+        },
+        [&](const Def* n) -> const Uses& { return uses(n); },
+        [&](const Def* n) {
+            Continuation* result = nullptr;
+            for (auto use : uses(n)) {
+                auto cont = late_[use];
+                result = result ? domtree().least_common_ancestor(cfg(result), cfg(cont))->continuation() : cont;
+            }
+            late_[n] = result;
+        });
 
-    return late_[def] = result;
+    return late_[def];
 }
 
 Continuation* Scheduler::smart(const Def* def) {
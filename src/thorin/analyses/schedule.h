@@ -20,6 +20,8 @@ public:
     const CFNode* cfg(Continuation* cont) const { return cfg()[cont]; }
     const DomTree& domtree() const { return *domtree_; }
     const Uses& uses(const Def* def) const { return def2uses_.find(def)->second; }
+    /// Is @p def live, i.e. transitively used by a @p Continuation of this @p Scope?
+    bool is_live(const Def* def) const { return def2uses_.contains(def); }
     //@}
 
     /// @name compute schedules
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <queue>
 
 #include "thorin/continuation.h"
 #include "thorin/world.h"
@@ -9,6 +10,7 @@
 #include "thorin/analyses/domtree.h"
 #include "thorin/analyses/looptree.h"
 #include "thorin/analyses/schedule.h"
+#include "thorin/util/utility.h"
 
 namespace thorin {
 
@@ -141,4 +143,44 @@ void Scope::for_each(const World& world, std::function<void(Scope&)> f) {
 template void Scope::for_each<true> (const World&, std::function<void(Scope&)>);
 template void Scope::for_each<false>(const World&, std::function<void(Scope&)>);
 
+ContinuationSet accelerator_code(World& world, std::function<bool(Continuation*)> filter) {
+    ContinuationSet done;
+    std::queue<Continuation*> queue;
+    auto enqueue = [&](Continuation* continuation) {
+        if (!continuation->is_intrinsic() && done.emplace(continuation).second)
+            queue.push(continuation);
+    };
+
+    for (auto continuation : world.continuations()) {
+        if (visit_capturing_intrinsics(continuation, [&](Continuation* intrinsic) { return intrinsic->is_accelerator() && filter(intrinsic); }))
+            enqueue(continuation);
+    }
+    while (!queue.empty()) {
+        Scope scope(pop(queue));
+        for (auto def : scope.defs()) {
+            for (auto op : def->ops()) {
+                if (auto continuation = op->isa_continuation(); continuation != nullptr && !scope.contains(continuation))
+                    enqueue(continuation);
+            }
+        }
+    }
+    return done;
+}
+
+bool transform_in_rounds(World& world, std::function<bool(const Scope&)> transform, std::function<bool(Continuation*)> filter) {
+    bool result = false;
+    for (bool todo = true; todo;) {
+        todo = false;
+        auto kernels = accelerator_code(world, filter);
+        Scope::for_each(world, [&](const Scope& scope) {
+            if (!kernels.contains(scope.entry()))
+                todo |= transform(scope);
+        });
+        if (todo)
+            world.cleanup();
+        result |= todo;
+    }
+    return result;
+}
+
 }
@@ -81,6 +81,20 @@ private:
     mutable std::unique_ptr<const CFA> cfa_;
 };
 
+/**
+ * All @p Continuation%s that run within an accelerator call - either passed there or called from there.
+ * Only accelerator intrinsics for which @p filter holds are taken into account.
+ */
+ContinuationSet accelerator_code(World&, std::function<bool(Continuation*)> filter = [] (Continuation*) { return true; });
+
+/**
+ * Runs @p transform on all top-level @p Scope%s - except for the @p accelerator_code selected by @p filter - until it doesn't change anything anymore.
+ * After each round with changes, the @p World is cleaned up as the analyses must not see the dead remains of the previous round.
+ * The analyses of a @p Scope are stale after a change - @p transform must not rely on them for anything it has already changed.
+ * Returns whether any @p transform changed something.
+ */
+bool transform_in_rounds(World&, std::function<bool(const Scope&)> transform, std::function<bool(Continuation*)> filter = [] (Continuation*) { return true; });
+
 }
 
 #endif
@@ -0,0 +1,136 @@
+#include "thorin/analyses/scope_hash.h"
+
+#include <queue>
+
+#include "thorin/primop.h"
+#include "thorin/analyses/scope.h"
+
+namespace thorin {
+
+static hash_t hash_node(const Def* def) {
+    hash_t seed = hash_begin(uint8_t(def->tag()));
+    seed = hash_combine(seed, uint32_t(def->type()->gid()), uint32_t(def->num_ops()));
+    if (auto param = def->isa<Param>())
+        return hash_combine(seed, uint32_t(param->index()));
+    if (auto continuation = def->isa_continuation())
+        return hash_combine(seed, uint32_t(continuation->intrinsic()), uint32_t(continuation->cc()));
+    if (auto lit = def->isa<PrimLit>())
+        return hash_combine(seed, bitcast<uint64_t, Box>(lit->value()));
+    if (auto variant = def->isa<Variant>())
+        return hash_combine(seed, uint32_t(variant->index()));
+    if (auto extract = def->isa<VariantExtract>())
+        return hash_combine(seed, uint32_t(extract->index()));
+    return seed;
+}
+
+static bool equal_node(const Def* a, const Def* b) {
+    if (a->tag() != b->tag() || a->type() != b->type() || a->num_ops() != b->num_ops())
+        return false;
+    if (auto param = a->isa<Param>())
+        return param->index() == b->as<Param>()->index();
+    if (auto ca = a->isa_continuation()) {
+        auto cb = b->as_continuation();
+        return ca->intrinsic() == cb->intrinsic() && ca->cc() == cb->cc() && ca->num_params() == cb->num_params();
+    }
+    if (auto lit = a->isa<PrimLit>())
+        return lit->value() == b->as<PrimLit>()->value();
+    if (auto variant = a->isa<Variant>())
+        return variant->index() == b->as<Variant>()->index();
+    if (auto extract = a->isa<VariantExtract>())
+        return extract->index() == b->as<VariantExtract>()->index();
+    if (auto global = a->isa<Global>())
+        return global->is_mutable() == b->as<Global>()->is_mutable();
+    if (auto asm_a = a->isa<Assembly>()) {
+        auto asm_b = b->as<Assembly>();
+        auto eq = [](ArrayRef<std::string> x, ArrayRef<std::string> y) {
+            return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+        };
+        return asm_a->asm_template() == asm_b->asm_template()
+            && eq(asm_a->output_constraints(), asm_b->output_constraints())
+            && eq(asm_a->input_constraints(),  asm_b->input_constraints())
+            && eq(asm_a->clobbers(),           asm_b->clobbers())
+            && asm_a->flags() == asm_b->flags();
+    }
+    return true;
+}
+
+hash_t structural_hash(const Scope& scope) {
+    DefMap<uint32_t> def2id;
+    std::queue<const Def*> queue;
+    hash_t seed = hash_begin();
+
+    auto visit = [&](const Def* def) {
+        if (!scope.contains(def)) {
+            seed = hash_combine(seed, uint32_t(def->gid()));
+            return;
+        }
+
+        uint32_t id = def2id.size();
+        auto [i, inserted] = def2id.emplace(def, id);
+        seed = hash_combine(seed, i->second);
+        if (inserted) {
+            seed = hash_combine(seed, hash_node(def));
+            queue.push(def);
+        }
+    };
+
+    visit(scope.entry());
+    while (!queue.empty()) {
+        auto def = pop(queue);
+        if (auto param = def->isa<Param>())
+            visit(param->continuation());
+        else
+            for (auto op : def->ops())
+                visit(op);
+    }
+
+    return seed;
+}
+
+bool structurally_equal(const Scope& sa, const Scope& sb) {
+    if (&sa == &sb || sa.entry() == sb.entry())
+        return true;
+    if (sa.defs().size() != sb.defs().size())
+        return false;
+
+    DefMap<const Def*> a2b, b2a;
+    std::queue<std::pair<const Def*, const Def*>> queue;
+
+    auto visit = [&](const Def* a, const Def* b) {
+        bool in_a = sa.contains(a), in_b = sb.contains(b);
+        if (in_a != in_b)
+            return false;
+        if (!in_a)
+            return a == b;
+        if (auto i = a2b.find(a); i != a2b.end())
+            return i->second == b;
+        if (b2a.contains(b) || !equal_node(a, b))
+            return false;
+
+        a2b[a] = b;
+        b2a[b] = a;
+        queue.emplace(a, b);
+        return true;
+    };
+
+    if (!visit(sa.entry(), sb.entry()))
+        return false;
+
+    while (!queue.empty()) {
+        auto [a, b] = pop(queue);
+        if (auto param = a->isa<Param>()) {
+            if (!visit(param->continuation(), b->as<Param>()->continuation()))
+                return false;
+            continue;
+        }
+
+        for (size_t i = 0, e = a->num_ops(); i != e; ++i) {
+            if (!visit(a->op(i), b->op(i)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+}
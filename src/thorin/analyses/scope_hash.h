@@ -0,0 +1,26 @@
+#ifndef THORIN_ANALYSES_SCOPE_HASH_H
+#define THORIN_ANALYSES_SCOPE_HASH_H
+
+#include "thorin/util/hash.h"
+
+namespace thorin {
+
+class Scope;
+
+/**
+ * Hashes the structure of @p scope independently of the identities of the @p Def%s within the @p Scope.
+ * Free @p Def%s are hashed by identity.
+ * Structurally equal @p Scope%s - see @p structurally_equal - yield the same hash.
+ */
+hash_t structural_hash(const Scope& scope);
+
+/**
+ * Are @p a and @p b equal up to a renaming of the @p Def%s within both @p Scope%s?
+ * Both @p Scope%s must use the very same free @p Def%s.
+ * The visibility of both entries is ignored.
+ */
+bool structurally_equal(const Scope& a, const Scope& b);
+
+}
+
+#endif
@@ -0,0 +1,368 @@
+#include "thorin/analyses/value_range.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/domtree.h"
+#include "thorin/analyses/looptree.h"
+
+namespace thorin {
+
+/// Phis at loop headers are widened after this many updates.
+static const int widen_after = 3;
+
+Interval Interval::join(Interval other) const {
+    if (is_empty()) return other;
+    if (other.is_empty()) return *this;
+    return {std::min(lo, other.lo), std::max(hi, other.hi)};
+}
+
+Interval Interval::meet(Interval other) const { return {std::max(lo, other.lo), std::min(hi, other.hi)}; }
+
+Interval type_range(const Type* type) {
+    auto prim_type = type->isa<PrimType>();
+    if (prim_type == nullptr || prim_type->length() != 1)
+        return Interval::full();
+    if (is_type_bool(type))
+        return {0, 1};
+    if (!is_type_i(type))
+        return Interval::full();
+
+    auto bits = num_bits(prim_type->primtype_tag());
+    if (bits >= 64)
+        return Interval::full();
+    if (is_type_s(type))
+        return {-(int64_t(1) << (bits - 1)), (int64_t(1) << (bits - 1)) - 1};
+    return {0, (int64_t(1) << bits) - 1};
+}
+
+/// Hardware limits of the index and dimension queries of the GPU backends - @p callee must be the imported declaration of such a query.
+static Interval intrinsic_range(Continuation* callee) {
+    // CUDA, NVVM and AMDGPU never run more threads per block - OpenCL CPU devices may well do so
+    static const int64_t max_block = 1024;
+    static const int64_t max_grid  = std::numeric_limits<int32_t>::max();
+    static const auto ranges = [] {
+        std::vector<std::pair<std::string, Interval>> result;
+        for (std::string x : { "x", "y", "z" }) {
+            // NVVM
+            result.emplace_back("llvm.nvvm.read.ptx.sreg.tid."    + x, Interval(0, max_block - 1));
+            result.emplace_back("llvm.nvvm.read.ptx.sreg.ntid."   + x, Interval(1, max_block));
+            result.emplace_back("llvm.nvvm.read.ptx.sreg.ctaid."  + x, Interval(0, max_grid - 1));
+            result.emplace_back("llvm.nvvm.read.ptx.sreg.nctaid." + x, Interval(1, max_grid));
+            // CUDA
+            result.emplace_back("threadIdx_" + x, Interval(0, max_block - 1));
+            result.emplace_back("blockDim_"  + x, Interval(1, max_block));
+            result.emplace_back("blockIdx_"  + x, Interval(0, max_grid - 1));
+            result.emplace_back("gridDim_"   + x, Interval(1, max_grid));
+            // AMDGPU
+            result.emplace_back("llvm.amdgcn.workitem.id."  + x, Interval(0, max_block - 1));
+            result.emplace_back("llvm.amdgcn.workgroup.id." + x, Interval(0, max_grid - 1));
+        }
+        // OpenCL
+        result.emplace_back("get_local_id",   Interval(0, max_grid - 1));
+        result.emplace_back("get_local_size", Interval(1, max_grid));
+        result.emplace_back("get_group_id",   Interval(0, max_grid - 1));
+        result.emplace_back("get_num_groups", Interval(1, max_grid));
+        return result;
+    }();
+
+    // a function of the program may well have the same name
+    if (!callee->empty())
+        return Interval::full();
+    for (const auto& [name, range] : ranges) {
+        if (callee->name() == name)
+            return range;
+    }
+    return Interval::full();
+}
+
+//------------------------------------------------------------------------------
+
+/*
+ * checked arithmetic - std::nullopt on overflow
+ */
+
+static std::optional<int64_t> checked_add(int64_t a, int64_t b) {
+    if ((b > 0 && a > Interval::max - b) || (b < 0 && a < Interval::min - b)) return std::nullopt;
+    return a + b;
+}
+
+static std::optional<int64_t> checked_sub(int64_t a, int64_t b) {
+    if ((b < 0 && a > Interval::max + b) || (b > 0 && a < Interval::min + b)) return std::nullopt;
+    return a - b;
+}
+
+static std::optional<int64_t> checked_mul(int64_t a, int64_t b) {
+    if (a == 0 || b == 0) return 0;
+    if (a > 0 ? (b > 0 ? a > Interval::max / b : b < Interval::min / a)
+              : (b > 0 ? a < Interval::min / b : a < Interval::max / b))
+        return std::nullopt;
+    return a * b;
+}
+
+template<class F>
+static Interval combine(Interval a, Interval b, F f) {
+    std::optional<int64_t> vals[4] = { f(a.lo, b.lo), f(a.lo, b.hi), f(a.hi, b.lo), f(a.hi, b.hi) };
+    Interval result;
+    for (auto val : vals) {
+        if (!val) return Interval::full();
+        result = result.join({*val, *val});
+    }
+    return result;
+}
+
+/// Smallest 2^n - 1 which is at least @p i.
+static int64_t mask(int64_t i) {
+    int64_t result = 0;
+    while (result < i)
+        result = (result << 1) | 1;
+    return result;
+}
+
+static Interval arithop_range(ArithOpTag tag, Interval a, Interval b) {
+    if (a.is_empty() || b.is_empty())
+        return Interval();
+
+    auto is_const = [](Interval r) { return r.lo == r.hi; };
+    switch (tag) {
+        case ArithOp_add: return combine(a, b, checked_add);
+        case ArithOp_sub: return combine(a, b, checked_sub);
+        case ArithOp_mul: return combine(a, b, checked_mul);
+        case ArithOp_div:
+            if (is_const(b) && b.lo > 0)
+                return {a.lo / b.lo, a.hi / b.lo};
+            break;
+        case ArithOp_rem:
+            if (is_const(b) && b.lo > 0)
+                return a.lo >= 0 ? Interval(0, std::min(a.hi, b.lo - 1)) : Interval(-(b.lo - 1), b.lo - 1);
+            break;
+        case ArithOp_and:
+            if (a.lo >= 0 && b.lo >= 0) return {0, std::min(a.hi, b.hi)};
+            if (a.lo >= 0) return {0, a.hi};
+            if (b.lo >= 0) return {0, b.hi};
+            break;
+        case ArithOp_or:
+        case ArithOp_xor:
+            if (a.lo >= 0 && b.lo >= 0)
+                return {0, mask(std::max(a.hi, b.hi))};
+            break;
+        case ArithOp_shl:
+            if (is_const(b) && b.lo >= 0 && b.lo < 63)
+                return combine(a, {int64_t(1) << b.lo, int64_t(1) << b.lo}, checked_mul);
+            break;
+        case ArithOp_shr:
+            if (is_const(b) && b.lo >= 0 && b.lo < 64 && a.lo >= 0)
+                return {a.lo >> b.lo, a.hi >> b.lo};
+            break;
+        default:
+            break;
+    }
+    return Interval::full();
+}
+
+//------------------------------------------------------------------------------
+
+ValueRanges::ValueRanges(const Scope& scope)
+    : scope_(scope)
+    , cfg_(scope.f_cfg())
+{
+    run();
+}
+
+bool ValueRanges::is_phi(Continuation* continuation) const {
+    if (continuation == scope().entry() || continuation->is_intrinsic() || !scope().contains(continuation))
+        return false;
+    for (auto use : continuation->uses()) {
+        if (!use->isa_continuation() || use.index() != 0)
+            return false;
+    }
+    return true;
+}
+
+bool ValueRanges::is_header(Continuation* continuation) const {
+    auto n = cfg_[continuation];
+    if (n == nullptr)
+        return false;
+    auto head = cfg_.looptree()[n]->parent();
+    return !head->is_root() && std::find(head->cf_nodes().begin(), head->cf_nodes().end(), n) != head->cf_nodes().end();
+}
+
+void ValueRanges::run() {
+    ParamMap<int> updates;
+    for (bool todo = true; todo;) {
+        todo = false;
+        cache_.clear();
+        constraints_.clear();
+
+        for (auto n : cfg_.reverse_post_order()) {
+            auto continuation = n->continuation();
+            if (continuation->empty())
+                continue;
+            auto callee = continuation->callee()->isa_continuation();
+            if (callee == nullptr || !is_phi(callee))
+                continue;
+
+            for (size_t i = 0, e = continuation->num_args(); i != e; ++i) {
+                auto param = callee->param(i);
+                if (!is_type_i(param->type()))
+                    continue;
+
+                auto cur = phis_.lookup(param).value_or(Interval());
+                auto nrange = cur.join(range(continuation->arg(i), continuation));
+                if (nrange == cur)
+                    continue;
+
+                if (++updates[param] > widen_after && is_header(callee)) {
+                    auto limits = type_range(param->type());
+                    if (nrange.lo < cur.lo) nrange.lo = limits.lo;
+                    if (nrange.hi > cur.hi) nrange.hi = limits.hi;
+                }
+                phis_[param] = nrange;
+                todo = true;
+            }
+        }
+    }
+
+    cache_.clear();
+    constraints_.clear();
+}
+
+Interval ValueRanges::param_range(const Param* param) {
+    auto continuation = param->continuation();
+    if (is_phi(continuation))
+        return phis_.lookup(param).value_or(Interval());
+
+    // continuation receives the result of a call
+    for (auto use : continuation->uses()) {
+        if (auto call = use->isa_continuation(); call && use.index() != 0) {
+            if (auto callee = call->callee()->isa_continuation())
+                return intrinsic_range(callee).meet(type_range(param->type()));
+        }
+    }
+    return type_range(param->type());
+}
+
+const ParamMap<Interval>& ValueRanges::constraints(Continuation* context) {
+    if (auto i = constraints_.find(context); i != constraints_.end())
+        return i->second;
+
+    ParamMap<Interval> result;
+    auto n = cfg_[context];
+    if (n != nullptr && context != scope().entry()) {
+        if (auto idom = cfg_.domtree().idom(n); idom != n)
+            result = constraints(idom->continuation());
+
+        const auto& preds = cfg_.preds(n);
+        if (preds.size() == 1) {
+            auto pred = (*preds.begin())->continuation();
+            auto callee = pred->empty() ? nullptr : pred->callee()->isa_continuation();
+            if (callee && callee->intrinsic() == Intrinsic::Branch && pred->arg(1) != pred->arg(2))
+                refine(result, pred->arg(0), pred->arg(1) == context, pred);
+        }
+    }
+
+    return constraints_[context] = std::move(result);
+}
+
+/// @c a tag b is equivalent to @c b swap_cmp(tag) a.
+static CmpTag swap_cmp(CmpTag tag) {
+    switch (tag) {
+        case Cmp_gt: return Cmp_lt;
+        case Cmp_ge: return Cmp_le;
+        case Cmp_lt: return Cmp_gt;
+        case Cmp_le: return Cmp_ge;
+        default:     return tag;
+    }
+}
+
+void ValueRanges::refine(ParamMap<Interval>& result, const Def* cond, bool taken, Continuation* context) {
+    auto cmp = cond->isa<Cmp>();
+    if (cmp == nullptr || !is_type_i(cmp->lhs()->type()))
+        return;
+
+    auto tag = taken ? cmp->cmp_tag() : negate(cmp->cmp_tag());
+    auto sides = std::array {
+        std::tuple { cmp->lhs(), cmp->rhs(), tag },
+        std::tuple { cmp->rhs(), cmp->lhs(), swap_cmp(tag) }
+    };
+
+    for (auto [x, y, tag] : sides) {
+        auto param = x->isa<Param>();
+        if (param == nullptr || !scope().contains(param))
+            continue;
+        auto other = range(y, context);
+        if (other.is_empty() || other.is_full())
+            continue;
+
+        // unsigned values beyond int64_t look negative - so only upper bounds are sound for them
+        bool is_unsigned = is_type_u(param->type());
+        Interval bound = Interval::full();
+        switch (tag) {
+            case Cmp_eq: bound = other; break;
+            case Cmp_lt: bound.hi = other.hi == Interval::min ? Interval::min : other.hi - 1; break;
+            case Cmp_le: bound.hi = other.hi; break;
+            case Cmp_gt: if (!is_unsigned) bound.lo = other.lo == Interval::max ? Interval::max : other.lo + 1; break;
+            case Cmp_ge: if (!is_unsigned) bound.lo = other.lo; break;
+            default: break;
+        }
+        if (is_unsigned && bound.hi != Interval::max)
+            bound.lo = 0;
+
+        auto cur = result.lookup(param).value_or(Interval::full());
+        result[param] = cur.meet(bound);
+    }
+}
+
+Interval ValueRanges::range(const Def* def, Continuation* context) {
+    if (auto i = cache_[context].find(def); i != cache_[context].end())
+        return i->second;
+
+    auto type = def->type();
+    Interval result = type_range(type);
+    if (auto lit = def->isa<PrimLit>()) {
+        if (is_type_bool(type)) {
+            result = {lit->value().get_bool(), lit->value().get_bool()};
+        } else if (is_type_i(type)) {
+            auto val = is_type_s(type) ? primlit_value<int64_t>(lit) : int64_t(primlit_value<uint64_t>(lit));
+            result = {val, val};
+        }
+    } else if (auto param = def->isa<Param>()) {
+        if (scope().contains(param)) {
+            result = param_range(param);
+            const auto& constraints = this->constraints(context);
+            if (auto bound = constraints.lookup(param))
+                result = result.meet(*bound);
+        }
+    } else if (auto arithop = def->isa<ArithOp>()) {
+        if (is_type_i(type)) {
+            auto a = range(arithop->lhs(), context);
+            auto b = range(arithop->rhs(), context);
+            auto r = arithop_range(arithop->arithop_tag(), a, b);
+            // values beyond the type wrap around
+            auto limits = type_range(type);
+            result = r.is_empty() || r.within(limits.lo, limits.hi) ? r : limits;
+        }
+    } else if (auto cast = def->isa<Cast>()) {
+        auto from = cast->from();
+        if (is_type_i(type) && (is_type_i(from->type()) || is_type_bool(from->type()))) {
+            auto r = range(from, context);
+            auto limits = type_range(type);
+            if (r.is_empty() || r.within(limits.lo, limits.hi))
+                result = r;
+        }
+    } else if (auto select = def->isa<Select>()) {
+        if (is_type_i(type))
+            result = range(select->tval(), context).join(range(select->fval(), context));
+    }
+
+    // ranges of unsigned values must not wrap around - values beyond int64_t are unknown
+    if (is_type_u(type) && !result.is_empty() && result.lo < 0)
+        result = Interval::full();
+
+    return cache_[context][def] = result;
+}
+
+}
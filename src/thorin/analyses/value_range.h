@@ -0,0 +1,81 @@
+#ifndef THORIN_ANALYSES_VALUE_RANGE_H
+#define THORIN_ANALYSES_VALUE_RANGE_H
+
+#include <cstdint>
+#include <limits>
+
+#include "thorin/def.h"
+#include "thorin/analyses/cfg.h"
+
+namespace thorin {
+
+/// A closed interval [@p lo, @p hi] of integers; @p lo > @p hi denotes the empty range.
+struct Interval {
+    static constexpr int64_t min = std::numeric_limits<int64_t>::min();
+    static constexpr int64_t max = std::numeric_limits<int64_t>::max();
+
+    Interval()
+        : lo(max)
+        , hi(min)
+    {}
+    Interval(int64_t lo, int64_t hi)
+        : lo(lo)
+        , hi(hi)
+    {}
+
+    /// Any value - also used for 64-bit values whose range we do not know.
+    static Interval full() { return {min, max}; }
+
+    bool is_empty() const { return lo > hi; }
+    bool is_full() const { return lo == min && hi == max; }
+    /// Is this range non-empty and within [@p l, @p h]?
+    bool within(int64_t l, int64_t h) const { return !is_empty() && l <= lo && hi <= h; }
+    Interval join(Interval other) const;
+    Interval meet(Interval other) const;
+
+    bool operator==(Interval other) const { return (is_empty() && other.is_empty()) || (lo == other.lo && hi == other.hi); }
+    bool operator!=(Interval other) const { return !(*this == other); }
+
+    int64_t lo;
+    int64_t hi;
+};
+
+/// All values of the integer @p type - or @p Interval::full for any other type.
+Interval type_range(const Type* type);
+
+/**
+ * Computes @p Interval%s of integer values within a @p Scope.
+ * @c mem @p Param%s aside, the @p Param%s of @p Continuation%s which are only jumped to are phis: they get the join of all incoming arguments.
+ * At loop headers - according to the @p LoopTree - the ranges of these phis are widened after a few rounds.
+ * The conditions of @c branch%es refine the ranges of @p Param%s in all @p Continuation%s dominated by the respective edge.
+ * Results of imported GPU intrinsics - e.g. @c threadIdx_x or @c blockDim_x - are bounded by the hardware limits.
+ */
+class ValueRanges {
+public:
+    ValueRanges(const ValueRanges&) = delete;
+    ValueRanges& operator=(ValueRanges) = delete;
+
+    explicit ValueRanges(const Scope&);
+
+    const Scope& scope() const { return scope_; }
+    /// The @p Interval of @p def when evaluated in @p context.
+    Interval range(const Def* def, Continuation* context);
+
+private:
+    void run();
+    bool is_phi(Continuation*) const;
+    bool is_header(Continuation*) const;
+    Interval param_range(const Param*);
+    const ParamMap<Interval>& constraints(Continuation*);
+    void refine(ParamMap<Interval>&, const Def* cond, bool taken, Continuation* context);
+
+    const Scope& scope_;
+    const F_CFG& cfg_;
+    ParamMap<Interval> phis_;
+    ContinuationMap<DefMap<Interval>> cache_;
+    ContinuationMap<ParamMap<Interval>> constraints_;
+};
+
+}
+
+#endif
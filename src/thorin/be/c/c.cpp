@@ -163,11 +163,18 @@ std::string CCodeGen::convert(const Type* type) {
         s.fmt("\b\n}} {};\n", name);
     } else if (auto variant = type->isa<VariantType>()) {
         types_[variant] = name = variant->name().str();
+        // null encodes the unit alternative - no need for a tag
+        if (auto ptr = variant->nullable_ptr()) {
+            s.fmt("typedef {} {};\n", convert(variant->op(*ptr)), name);
+            type_decls_ << s.str();
+            return name;
+        }
+
         auto tag_type =
-            variant->num_ops() < (UINT64_C(1) <<  8u) ? world_.type_qu8()  :
-            variant->num_ops() < (UINT64_C(1) << 16u) ? world_.type_qu16() :
-            variant->num_ops() < (UINT64_C(1) << 32u) ? world_.type_qu32() :
-                                                        world_.type_qu64();
+            variant->tag_bits() ==  8 ? world_.type_qu8()  :
+            variant->tag_bits() == 16 ? world_.type_qu16() :
+            variant->tag_bits() == 32 ? world_.type_qu32() :
+                                        world_.type_qu64();
         s.fmt("typedef struct {{\t\n");
 
         // This is required because we have zero-sized types but C/C++ do not
@@ -544,6 +551,14 @@ void CCodeGen::emit_epilogue(Continuation* cont) {
     }
 }
 
+/// The pointer to the first element of the vector @p ptr points to - OpenCL only loads and stores unaligned vectors via such pointers.
+static const PtrType* elem_ptr_type(const Def* ptr) {
+    auto& world = ptr->world();
+    auto ptr_type = ptr->type()->as<PtrType>();
+    auto elem_type = world.prim_type(ptr_type->pointee()->as<PrimType>()->primtype_tag());
+    return world.ptr_type(elem_type, 1, ptr_type->device(), ptr_type->addr_space());
+}
+
 static inline bool is_definite_to_indefinite_array_cast(const PtrType* from, const PtrType* to) {
     return
         from->pointee()->isa<DefiniteArrayType>() &&
@@ -566,6 +581,8 @@ std::string CCodeGen::emit_constant(const Def* def) {
         return s.str();
     } else if (auto variant = def->isa<Variant>()) {
         auto variant_type = variant->type()->as<VariantType>();
+        if (auto ptr = variant_type->nullable_ptr())
+            return variant->index() == *ptr ? emit_constant(variant->value()) : "0";
         s.fmt("{} ", constructor_prefix(variant_type));
         if (variant_type->has_payload()) {
             if (auto value = emit_constant(variant->value()); !value.empty())
@@ -650,6 +667,8 @@ std::string CCodeGen::emit_bottom(const Type* type) {
         s << " }";
         return s.str();
     } else if (auto variant_type = type->isa<VariantType>()) {
+        if (variant_type->nullable_ptr())
+            return "0";
         if (variant_type->has_payload()) {
             auto non_unit = *std::find_if(variant_type->ops().begin(), variant_type->ops().end(),
                 [] (const Type* op) { return !is_type_unit(op); });
@@ -853,27 +872,43 @@ std::string CCodeGen::emit_bb(BB& bb, const Def* def) {
         return emit_constant(primlit);
     } else if (auto variant = def->isa<Variant>()) {
         func_impls_.fmt("{} {};\n", convert(variant->type()), name);
-        if (auto value = emit_unsafe(variant->value()); !value.empty())
-            bb.body.fmt("{}.data.{} = {};\n", name, variant->type()->as<VariantType>()->op_name(variant->index()), value);
-        bb.body.fmt("{}.tag = {};\n", name, variant->index());
+        if (auto ptr = variant->type()->nullable_ptr()) {
+            bb.body.fmt("{} = {};\n", name, variant->index() == *ptr ? emit(variant->value()) : "0");
+        } else {
+            if (auto value = emit_unsafe(variant->value()); !value.empty())
+                bb.body.fmt("{}.data.{} = {};\n", name, variant->type()->as<VariantType>()->op_name(variant->index()), value);
+            bb.body.fmt("{}.tag = {};\n", name, variant->index());
+        }
     } else if (auto variant_index = def->isa<VariantIndex>()) {
         func_impls_.fmt("{} {};\n", convert(variant_index->type()), name);
-        bb.body.fmt("{} = {}.tag;\n", name, emit(variant_index->op(0)));
+        if (auto ptr = variant_index->op(0)->type()->as<VariantType>()->nullable_ptr())
+            bb.body.fmt("{} = {} == 0 ? {} : {};\n", name, emit(variant_index->op(0)), 1 - *ptr, *ptr);
+        else
+            bb.body.fmt("{} = {}.tag;\n", name, emit(variant_index->op(0)));
     } else if (auto variant_extract = def->isa<VariantExtract>()) {
         func_impls_.fmt("{} {};\n", convert(variant_extract->type()), name);
         auto variant_type = variant_extract->value()->type()->as<VariantType>();
-        bb.body.fmt("{} = {}.data.{};\n", name, emit(variant_extract->value()), variant_type->op_name(variant_extract->index()));
+        if (variant_type->nullable_ptr())
+            bb.body.fmt("{} = {};\n", name, emit(variant_extract->value()));
+        else
+            bb.body.fmt("{} = {}.data.{};\n", name, emit(variant_extract->value()), variant_type->op_name(variant_extract->index()));
     } else if (auto load = def->isa<Load>()) {
         emit_unsafe(load->mem());
         auto ptr = emit(load->ptr());
         func_impls_.fmt("{} {};\n", convert(load->out_val()->type()), name);
-        bb.body.fmt("{} = *{};\n", name, ptr);
+        if (auto vector = load->out_val_type()->isa<PrimType>(); lang_ == Lang::OpenCL && vector && vector->is_vector())
+            bb.body.fmt("{} = vload{}(0, ({}){});\n", name, vector->length(), convert(elem_ptr_type(load->ptr())), ptr);
+        else
+            bb.body.fmt("{} = *{};\n", name, ptr);
     } else if (auto store = def->isa<Store>()) {
         // TODO: IndefiniteArray should be removed
         if (store->val()->isa<IndefiniteArray>())
             return "";
         emit_unsafe(store->mem());
-        bb.body.fmt("*{} = {};\n", emit(store->ptr()), emit(store->val()));
+        if (auto vector = store->val()->type()->isa<PrimType>(); lang_ == Lang::OpenCL && vector && vector->is_vector())
+            bb.body.fmt("vstore{}({}, 0, ({}){});\n", vector->length(), emit(store->val()), convert(elem_ptr_type(store->ptr())), emit(store->ptr()));
+        else
+            bb.body.fmt("*{} = {};\n", emit(store->ptr()), emit(store->val()));
         return "";
     } else if (auto slot = def->isa<Slot>()) {
         emit_unsafe(slot->frame());
@@ -894,6 +929,10 @@ std::string CCodeGen::emit_bb(BB& bb, const Def* def) {
         }
     } else if (auto enter = def->isa<Enter>()) {
         return emit_unsafe(enter->mem());
+    } else if (auto join = def->isa<Join>()) {
+        for (auto mem : join->mems())
+            emit_unsafe(mem);
+        return "";
     } else if (auto lea = def->isa<LEA>()) {
         auto ptr = emit(lea->ptr());
         auto index = emit(lea->index());
@@ -1,5 +1,9 @@
 #include "thorin/be/codegen.h"
 #include "thorin/analyses/scope.h"
+#include "thorin/transform/aos_to_soa.h"
+#include "thorin/transform/narrow_ints.h"
+#include "thorin/transform/slp_vectorize.h"
+#include "thorin/transform/split_effects.h"
 
 #if THORIN_ENABLE_LLVM
 #include "thorin/be/llvm/cpu.h"
@@ -10,14 +14,21 @@
 
 namespace thorin {
 
+/// Combines the configurations of two launch sites of the same kernel such that @p config is valid for both.
+static void merge_kernel_configs(std::unique_ptr<KernelConfig>& config, const KernelConfig* other) {
+    auto gpu_config = config->isa<GPUKernelConfig>();
+    auto gpu_other  = other->isa<GPUKernelConfig>();
+    assert(gpu_config && gpu_other && "only GPU kernels are deduplicated");
+    auto block = gpu_config->block_size() == gpu_other->block_size() ? gpu_config->block_size() : std::tuple<int, int, int>{-1, -1, -1};
+    config = std::make_unique<GPUKernelConfig>(block, gpu_config->has_restrict() && gpu_other->has_restrict());
+}
+
 static void get_kernel_configs(
     Importer& importer,
     const std::vector<Continuation*>& kernels,
     Cont2Config& kernel_config,
     std::function<std::unique_ptr<KernelConfig> (Continuation*, Continuation*)> use_callback)
 {
-    importer.world().opt();
-
     auto exported_continuations = importer.world().exported_continuations();
     for (auto continuation : kernels) {
         // recover the imported continuation (lost after the call to opt)
@@ -31,8 +42,10 @@ static void get_kernel_configs(
         visit_uses(continuation, [&] (Continuation* use) {
             auto config = use_callback(use, imported);
             if (config) {
-                auto p = kernel_config.emplace(imported, std::move(config));
-                assert_unused(p.second && "single kernel config entry expected");
+                if (auto i = kernel_config.find(imported); i != kernel_config.end())
+                    merge_kernel_configs(i->second, config.get()); // deduplicated kernel launched from several places
+                else
+                    kernel_config.emplace(imported, std::move(config));
             }
             return false;
         }, true);
@@ -74,6 +87,10 @@ static uint64_t get_alloc_size(const Def* def) {
 DeviceBackends::DeviceBackends(World& world, int opt, bool debug)
     : cgs {}
 {
+    // host and device code must agree on the layout of the buffers - so change it before the kernels are split off
+    if (aos_to_soa(world))
+        world.cleanup();
+
     for (size_t i = 0; i < cgs.size(); ++i)
         importers_.emplace_back(world);
 
@@ -110,6 +127,8 @@ DeviceBackends::DeviceBackends(World& world, int opt, bool debug)
 
     for (auto backend : std::array { CUDA, NVVM, OpenCL, AMDGPU }) {
         if (!importers_[backend].world().empty()) {
+            importers_[backend].world().opt(Target::GPU);
+            narrow_ints(importers_[backend].world());
             get_kernel_configs(importers_[backend], kernels, kernel_config, [&](Continuation *use, Continuation * /* imported */) {
                 // determine whether or not this kernel uses restrict pointers
                 bool has_restrict = true;
@@ -135,11 +154,29 @@ DeviceBackends::DeviceBackends(World& world, int opt, bool debug)
                 }
                 return std::make_unique<GPUKernelConfig>(std::tuple<int, int, int>{-1, -1, -1}, has_restrict);
             });
+
+            // the pointers of restrict kernels give rise to effect regions of their own
+            ContinuationSet restrict;
+            for (auto& [kernel, config] : kernel_config) {
+                if (auto gpu_config = config->isa<GPUKernelConfig>(); gpu_config && gpu_config->has_restrict() && &kernel->world() == &importers_[backend].world())
+                    restrict.emplace(kernel);
+            }
+            if (!restrict.empty()) {
+                split_effects(importers_[backend].world(), restrict);
+                importers_[backend].world().cleanup();
+            }
+
+            // only OpenCL has vector arithmetic on GPUs (float4 etc.)
+            if (backend == OpenCL) {
+                slp_vectorize(importers_[backend].world(), {4});
+                importers_[backend].world().cleanup();
+            }
         }
     }
 
     // get the HLS kernel configurations
     if (!importers_[HLS].world().empty()) {
+        importers_[HLS].world().opt(Target::HLS);
         get_kernel_configs(importers_[HLS], kernels, kernel_config, [&] (Continuation* use, Continuation* imported) {
             HLSKernelConfig::Param2Size param_sizes;
             for (size_t i = 3, e = use->num_args(); i != e; ++i) {
@@ -36,6 +36,7 @@
 #include "thorin/primop.h"
 #include "thorin/type.h"
 #include "thorin/world.h"
+#include "thorin/analyses/escape.h"
 #include "thorin/analyses/scope.h"
 #include "thorin/util/array.h"
 
@@ -201,6 +202,11 @@ llvm::Type* CodeGen::convert(const Type* type) {
 
         case Node_VariantType: {
             assert(type->num_ops() > 0);
+            auto variant_type = type->as<VariantType>();
+            // null encodes the unit alternative - no need for a tag
+            if (auto ptr = variant_type->nullable_ptr())
+                return convert(variant_type->op(*ptr));
+
             // Max alignment/size constraints respectively in the variant type alternatives dictate the ones to use for the overall type
             size_t max_align = 0, max_size = 0;
 
@@ -223,11 +229,7 @@ llvm::Type* CodeGen::convert(const Type* type) {
                     ? llvm::StructType::get(context(), llvm::ArrayRef<llvm::Type*> { max_align_type, llvm::ArrayType::get(llvm::Type::getInt8Ty(context()), rem_size)})
                     : llvm::StructType::get(context(), llvm::ArrayRef<llvm::Type*> { max_align_type });
 
-            auto tag_type = type->num_ops() < (1_u64 <<  8) ? llvm::Type::getInt8Ty (context()) :
-                            type->num_ops() < (1_u64 << 16) ? llvm::Type::getInt16Ty(context()) :
-                            type->num_ops() < (1_u64 << 32) ? llvm::Type::getInt32Ty(context()) :
-                                                              llvm::Type::getInt64Ty(context());
-
+            auto tag_type = llvm::Type::getIntNTy(context(), variant_type->tag_bits());
             return llvm::StructType::get(context(), { union_type, tag_type });
         }
 
@@ -544,6 +546,11 @@ llvm::Value* CodeGen::emit_bb(BB& bb, const Def* def) {
     else if (auto lea = def->isa<LEA>())             return emit_lea(irbuilder, lea);
     else if (auto assembly = def->isa<Assembly>())   return emit_assembly(irbuilder, assembly);
     else if (def->isa<Enter>())                      return emit_unsafe(def->op(0));
+    else if (def->isa<Join>()) {
+        for (auto mem : def->ops())
+            emit_unsafe(mem);
+        return nullptr;
+    }
     else if (auto bin = def->isa<BinOp>()) {
         llvm::Value* lhs = emit(bin->lhs());
         llvm::Value* rhs = emit(bin->rhs());
@@ -741,8 +748,14 @@ llvm::Value* CodeGen::emit_bb(BB& bb, const Def* def) {
                     env = emit(world().cast(Closure::environment_type(world()), val));
                 }
             } else {
-                world().wdef(def, "closure '{}' is leaking memory, type '{}' is too large", def, agg->op(1)->type());
-                auto alloc = emit_alloc(irbuilder, val->type(), nullptr);
+                llvm::Value* alloc = nullptr;
+                if (escapes(closure)) {
+                    world().wdef(def, "closure '{}' is leaking memory, type '{}' is too large", def, agg->op(1)->type());
+                    alloc = emit_alloc(irbuilder, val->type(), nullptr);
+                } else {
+                    // the closure is only called while this frame is alive
+                    alloc = emit_alloca(irbuilder, convert(val->type()), closure->unique_name() + "_env");
+                }
                 irbuilder.CreateStore(emit(val), alloc);
                 env = irbuilder.CreatePtrToInt(alloc, convert(Closure::environment_type(world())));
             }
@@ -815,6 +828,12 @@ llvm::Value* CodeGen::emit_bb(BB& bb, const Def* def) {
         return irbuilder.CreateInsertValue(llvm_agg, value, {primlit_value<unsigned>(aggop->index())});
     } else if (auto variant_index = def->isa<VariantIndex>()) {
         auto llvm_value = emit(variant_index->op(0));
+        auto variant_type = variant_index->op(0)->type()->as<VariantType>();
+        if (auto ptr = variant_type->nullable_ptr()) {
+            auto index_type = convert(variant_index->type());
+            return irbuilder.CreateSelect(irbuilder.CreateIsNull(llvm_value),
+                llvm::ConstantInt::get(index_type, 1 - *ptr), llvm::ConstantInt::get(index_type, *ptr));
+        }
         auto tag_value = irbuilder.CreateExtractValue(llvm_value, { 1 });
         return irbuilder.CreateIntCast(tag_value, convert(variant_index->type()), false);
     } else if (auto variant_extract = def->isa<VariantExtract>()) {
@@ -823,6 +842,8 @@ llvm::Value* CodeGen::emit_bb(BB& bb, const Def* def) {
         auto target_type   = variant_value->type()->op(variant_extract->index());
         if (is_type_unit(target_type))
             return nullptr;
+        if (variant_value->type()->as<VariantType>()->nullable_ptr())
+            return llvm_value;
 
         auto payload_value = irbuilder.CreateExtractValue(llvm_value, { 0 });
         return create_tmp_alloca(irbuilder, payload_value->getType(), [&] (llvm::AllocaInst* alloca) {
@@ -833,7 +854,12 @@ llvm::Value* CodeGen::emit_bb(BB& bb, const Def* def) {
         });
     } else if (auto variant_ctor = def->isa<Variant>()) {
         auto llvm_type = convert(variant_ctor->type());
-        auto tag_value = irbuilder.getIntN(llvm_type->getStructElementType(1)->getScalarSizeInBits(), variant_ctor->index());
+        if (auto ptr = variant_ctor->type()->nullable_ptr()) {
+            if (variant_ctor->index() == *ptr)
+                return emit(variant_ctor->op(0));
+            return llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(llvm_type));
+        }
+        auto tag_value = irbuilder.getIntN(variant_ctor->type()->tag_bits(), variant_ctor->index());
 
         return create_tmp_alloca(irbuilder, llvm_type, [&] (llvm::AllocaInst* alloca) {
             auto tag_addr = irbuilder.CreateInBoundsGEP(alloca, { irbuilder.getInt32(0), irbuilder.getInt32(1) });
@@ -1034,12 +1060,19 @@ llvm::Value* CodeGen::call_math_function(llvm::IRBuilder<>& irbuilder, const Mat
     THORIN_UNREACHABLE;
 }
 
+/// Vectors are loaded and stored via pointers into arrays of their elements - so they are only aligned as an element.
+llvm::Align CodeGen::emit_alignment(llvm::Value* ptr) {
+    auto type = ptr->getType()->getPointerElementType();
+    if (auto vector_type = llvm::dyn_cast<llvm::VectorType>(type))
+        type = vector_type->getElementType();
+    return module().getDataLayout().getABITypeAlign(type);
+}
+
 llvm::Value* CodeGen::emit_load(llvm::IRBuilder<>& irbuilder, const Load* load) {
     emit_unsafe(load->mem());
     auto ptr = emit(load->ptr());
     auto result = irbuilder.CreateLoad(ptr);
-    auto align = module().getDataLayout().getABITypeAlign(ptr->getType()->getPointerElementType());
-    result->setAlignment(align);
+    result->setAlignment(emit_alignment(ptr));
     return result;
 }
 
@@ -1047,8 +1080,7 @@ llvm::Value* CodeGen::emit_store(llvm::IRBuilder<>& irbuilder, const Store* stor
     emit_unsafe(store->mem());
     auto ptr = emit(store->ptr());
     auto result = irbuilder.CreateStore(emit(store->val()), ptr);
-    auto align = module().getDataLayout().getABITypeAlign(ptr->getType()->getPointerElementType());
-    result->setAlignment(align);
+    result->setAlignment(emit_alignment(ptr));
     return nullptr;
 }
 
@@ -74,6 +74,7 @@ protected:
     virtual llvm::Value* map_param(llvm::Function*, llvm::Argument* a, const Param*) { return a; }
 
     virtual llvm::Value* emit_mathop  (llvm::IRBuilder<>&, const MathOp*);
+    llvm::Align emit_alignment(llvm::Value* ptr);
     virtual llvm::Value* emit_load    (llvm::IRBuilder<>&, const Load*);
     virtual llvm::Value* emit_store   (llvm::IRBuilder<>&, const Store*);
     virtual llvm::Value* emit_lea     (llvm::IRBuilder<>&, const LEA*);
@@ -158,6 +158,20 @@ void Continuation::set_all_true_filter() {
 }
 
 bool Continuation::is_accelerator() const { return Intrinsic::AcceleratorBegin <= intrinsic() && intrinsic() < Intrinsic::AcceleratorEnd; }
+
+bool Continuation::is_device_backend() const {
+    switch (intrinsic()) {
+        case Intrinsic::CUDA:
+        case Intrinsic::NVVM:
+        case Intrinsic::OpenCL:
+        case Intrinsic::AMDGPU:
+        case Intrinsic::HLS:
+            return true;
+        default:
+            return false;
+    }
+}
+
 void Continuation::set_intrinsic() {
     if      (name() == "cuda")           attributes().intrinsic = Intrinsic::CUDA;
     else if (name() == "nvvm")           attributes().intrinsic = Intrinsic::NVVM;
@@ -295,10 +309,17 @@ void Continuation::dump_jump() const { stream_jump(std::cout) << endl; }
 bool visit_uses(Continuation* cont, std::function<bool(Continuation*)> func, bool include_globals) {
     if (!cont->is_intrinsic()) {
         for (auto use : cont->uses()) {
-            auto def = include_globals && use->isa<Global>() ? use->uses().begin()->def() : use.def();
-            if (auto continuation = def->isa_continuation())
+            if (include_globals && use->isa<Global>()) {
+                // a kernel may be launched from several places via the same global
+                for (auto guse : use->uses()) {
+                    if (auto continuation = guse->isa_continuation())
+                        if (func(continuation))
+                            return true;
+                }
+            } else if (auto continuation = use->isa_continuation()) {
                 if (func(continuation))
                     return true;
+            }
         }
     }
     return false;
@@ -93,6 +93,8 @@ public:
         Intrinsic intrinsic = Intrinsic::None;
         Visibility visibility = Visibility::Internal;
         CC cc = CC::C;
+        /// Set by @p unroll on the headers of loops it has transformed so that it leaves them alone in later rounds.
+        bool unrolled = false;
 
         Attributes() = default;
         Attributes(Intrinsic intrinsic) : intrinsic(intrinsic) {}
@@ -141,6 +143,8 @@ public:
     bool is_imported() const { return is_external() && empty(); }
     bool is_exported() const { return is_external() && !empty(); }
     bool is_accelerator() const;
+    /// Is this an accelerator intrinsic whose body is compiled by a device backend with a world of its own?
+    bool is_device_backend() const;
     void destroy_body();
 
     // terminate
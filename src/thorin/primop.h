@@ -696,6 +696,22 @@ public:
     friend class World;
 };
 
+/// Joins the effects <tt>mems</tt> of independent memory chains into a single new effect.
+class Join : public MemOp {
+private:
+    Join(Defs mems, Debug dbg)
+        : MemOp(Node_Join, mems.front()->type(), mems, dbg)
+    {}
+
+    const Def* rebuild(World&, const Type*, Defs) const override;
+
+public:
+    Defs mems() const { return ops(); }
+    const MemType* type() const { return MemOp::type()->as<MemType>(); }
+
+    friend class World;
+};
+
 class Assembly : public MemOp {
 public:
     enum Flags {
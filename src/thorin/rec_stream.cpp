@@ -23,22 +23,25 @@ public:
 };
 
 void RecStreamer::run(const Def* def) {
-    if (def->no_dep() || !defs.emplace(def).second) return;
-
-    for (auto op : def->ops()) { // for now, don't include debug info and type
-        if (auto cont = op->isa_continuation()) {
-            if (max != 0) {
-                if (conts.push(cont)) --max;
+    post_order_walk(def,
+        [&](const Def* n) {
+            if (n != def) {
+                if (auto cont = n->isa_continuation()) {
+                    if (max != 0) {
+                        if (conts.push(cont)) --max;
+                    }
+                    return false;
+                }
             }
-        } else {
-            run(op);
-        }
-    }
-
-    if (auto cont = def->isa_continuation())
-        s.fmt("{}: {} = {}({, })", cont, cont->type(), cont->callee(), cont->args());
-    else if (!def->no_dep() && !def->isa<Param>())
-        def->stream_let(s);
+            return !n->no_dep() && defs.emplace(n).second;
+        },
+        [&](const Def* n) { return n->ops(); }, // for now, don't include debug info and type
+        [&](const Def* n) {
+            if (auto cont = n->isa_continuation())
+                s.fmt("{}: {} = {}({, })", cont, cont->type(), cont->callee(), cont->args());
+            else if (!n->no_dep() && !n->isa<Param>())
+                n->stream_let(s);
+        });
 }
 
 void RecStreamer::run() {
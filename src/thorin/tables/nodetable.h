@@ -17,6 +17,7 @@
                 THORIN_NODE(Store, store)
             THORIN_NODE(Enter, enter)
             THORIN_NODE(Leave, leave)
+            THORIN_NODE(Join, join)
         THORIN_NODE(Select, select)
         THORIN_NODE(AlignOf, align_of)
         THORIN_NODE(SizeOf, size_of)
@@ -0,0 +1,218 @@
+#include "thorin/transform/aos_to_soa.h"
+
+#include <algorithm>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/verify.h"
+#include "thorin/be/codegen.h"
+
+namespace thorin {
+
+static bool is_gpu_launch(Continuation* continuation) {
+    auto callee = continuation->callee()->isa_continuation();
+    if (callee == nullptr)
+        return false;
+    switch (callee->intrinsic()) {
+        case Intrinsic::CUDA:
+        case Intrinsic::NVVM:
+        case Intrinsic::OpenCL:
+        case Intrinsic::AMDGPU:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_scalar(const Type* type) {
+    auto prim_type = type->isa<PrimType>();
+    return prim_type != nullptr && !prim_type->is_vector();
+}
+
+static uint64_t num_bytes(const Type* type) {
+    return std::max(1, num_bits(type->as<PrimType>()->primtype_tag()) / 8);
+}
+
+class SoAConverter {
+public:
+    SoAConverter(Continuation* alloc)
+        : world_(alloc->world())
+        , alloc_(alloc)
+    {}
+
+    bool run();
+
+private:
+    bool check_buffer(const Def* ptr);
+    bool check_array(const Def* array);
+    bool check_element(const Def* element);
+    bool check_kernel(Continuation* launch, size_t i);
+    void rewrite(const LEA* field);
+
+    World& world_;
+    Continuation* alloc_;
+    const Type* byte_type_ = nullptr;
+    const Type* struct_type_ = nullptr;
+    std::vector<const LEA*> fields_;
+    Array<uint64_t> offsets_;
+};
+
+bool SoAConverter::run() {
+    // signature: anydsl_alloc(mem, i32, i64, fn(mem, &[i8]))
+    if (alloc_->num_args() != 4)
+        return false;
+    auto size = alloc_->arg(2)->isa<PrimLit>();
+    auto ret = alloc_->arg(3)->isa_continuation();
+    // another call returning to ret would pass a buffer we don't rewrite - see get_alloc_call in the code generator
+    if (size == nullptr || ret == nullptr || ret->num_params() != 2 || ret->num_uses() != 1)
+        return false;
+
+    auto ptr = ret->param(1);
+    auto ptr_type = ptr->type()->isa<PtrType>();
+    auto buffer_type = ptr_type != nullptr ? ptr_type->pointee()->isa<ArrayType>() : nullptr;
+    if (buffer_type == nullptr)
+        return false;
+    byte_type_ = buffer_type->elem_type();
+    if (!check_buffer(ptr) || struct_type_ == nullptr)
+        return false;
+
+    // the original layout as in C
+    auto field_types = struct_type_->ops();
+    uint64_t struct_size = 0, struct_align = 1;
+    for (auto field_type : field_types) {
+        auto n = num_bytes(field_type);
+        struct_size = (struct_size + n - 1) / n * n + n;
+        struct_align = std::max(struct_align, n);
+    }
+    struct_size = (struct_size + struct_align - 1) / struct_align * struct_align;
+
+    auto bytes = primlit_value<uint64_t>(size);
+    if (bytes % struct_size != 0)
+        return false;
+    auto num_elems = bytes / struct_size;
+
+    // one array per field - larger fields first so all of them stay aligned
+    Array<size_t> order(field_types.size(), [](size_t i) { return i; });
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return num_bytes(field_types[a]) > num_bytes(field_types[b]); });
+    offsets_ = Array<uint64_t>(field_types.size());
+    uint64_t offset = 0;
+    for (auto i : order) {
+        offsets_[i] = offset;
+        offset += num_elems * num_bytes(field_types[i]);
+    }
+
+    for (auto field : fields_)
+        rewrite(field);
+    alloc_->update_arg(2, world_.cast(size->type(), world_.literal_qu64(offset, size->debug()), size->debug()));
+
+    world_.ILOG("changed the layout of the buffer allocated in {} to a struct of arrays ({} instead of {} bytes)", alloc_, offset, bytes);
+    return true;
+}
+
+/// The buffer @p ptr as returned by @c anydsl_alloc may only be cast to an array of structs or released.
+bool SoAConverter::check_buffer(const Def* ptr) {
+    for (auto use : ptr->uses()) {
+        if (use->isa<Bitcast>()) {
+            if (!check_array(use.def()))
+                return false;
+        } else if (auto continuation = use->isa_continuation(); continuation != nullptr && use.index() != 0 && continuation->callee()->name() == "anydsl_release") {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The pointer @p array to the structs may only be indexed or passed to a GPU kernel.
+bool SoAConverter::check_array(const Def* array) {
+    auto ptr_type = array->type()->isa<PtrType>();
+    auto array_type = ptr_type != nullptr ? ptr_type->pointee()->isa<ArrayType>() : nullptr;
+    if (array_type == nullptr)
+        return false;
+
+    auto elem_type = array_type->elem_type();
+    if (!elem_type->isa<StructType>() && !elem_type->isa<TupleType>())
+        return false;
+    if (elem_type->num_ops() == 0 || !std::all_of(elem_type->ops().begin(), elem_type->ops().end(), is_scalar))
+        return false;
+    if (struct_type_ != nullptr && struct_type_ != elem_type)
+        return false;
+    struct_type_ = elem_type;
+
+    for (auto use : array->uses()) {
+        if (use->isa<LEA>() && use.index() == 0) {
+            if (!check_element(use.def()))
+                return false;
+        } else if (auto launch = use->isa_continuation(); launch != nullptr && is_gpu_launch(launch) && use.index() > LaunchArgs::Num) {
+            if (!check_kernel(launch, use.index() - 1))
+                return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The pointer @p element to a struct may only be used to load or store its fields.
+bool SoAConverter::check_element(const Def* element) {
+    for (auto use : element->uses()) {
+        auto field = use->isa<LEA>();
+        if (field == nullptr || use.index() != 0 || !field->index()->isa<PrimLit>())
+            return false;
+        for (auto field_use : field->uses()) {
+            if (!field_use->isa<Access>() || field_use.index() != 1)
+                return false;
+        }
+        fields_.push_back(field);
+    }
+    return true;
+}
+
+/// The argument @p i of the kernel @p launch is the array - the kernel must only access its fields as well.
+bool SoAConverter::check_kernel(Continuation* launch, size_t i) {
+    auto global = launch->arg(LaunchArgs::Body)->isa<Global>();
+    auto kernel = global != nullptr ? global->init()->isa_continuation() : nullptr;
+    if (kernel == nullptr || global->num_uses() != 1 || kernel->num_uses() != 1)
+        return false;
+
+    // lift_builtins appends the arguments after LaunchArgs::Num as parameters of the kernel
+    auto num_free = launch->num_args() - LaunchArgs::Num;
+    if (kernel->num_params() < num_free)
+        return false;
+    auto param = kernel->param(kernel->num_params() - num_free + i - LaunchArgs::Num);
+    return param->type() == launch->arg(i)->type() && check_array(param);
+}
+
+/// Rewrites <tt>lea(lea(array, index), field)</tt> to <tt>lea(array_of_field, index)</tt>.
+void SoAConverter::rewrite(const LEA* field) {
+    auto element = field->ptr()->as<LEA>();
+    auto array = element->ptr();
+    auto ptr_type = array->type()->as<PtrType>();
+    auto array_ptr_type = [&](const Type* elem_type) {
+        return world_.ptr_type(world_.indefinite_array_type(elem_type), 1, ptr_type->device(), ptr_type->addr_space());
+    };
+
+    auto i = primlit_value<size_t>(field->index());
+    auto dbg = field->debug();
+    auto bytes = world_.bitcast(array_ptr_type(byte_type_), array, dbg);
+    auto begin = world_.lea(bytes, world_.literal_qu64(offsets_[i], dbg), dbg);
+    auto column = world_.bitcast(array_ptr_type(struct_type_->op(i)), begin, dbg);
+    field->replace(world_.lea(column, element->index(), dbg));
+}
+
+bool aos_to_soa(World& world) {
+    world.VLOG("start aos_to_soa");
+
+    bool todo = false;
+    for (auto continuation : world.copy_continuations()) {
+        if (continuation->callee()->name() == "anydsl_alloc")
+            todo |= SoAConverter(continuation).run();
+    }
+
+    world.VLOG("end aos_to_soa");
+    debug_verify(world);
+    return todo;
+}
+
+}
@@ -0,0 +1,22 @@
+#ifndef THORIN_TRANSFORM_AOS_TO_SOA_H
+#define THORIN_TRANSFORM_AOS_TO_SOA_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Changes the layout of buffers from @c anydsl_alloc from an array of structs to a struct of arrays.
+ * A buffer qualifies if
+ *  - its size is known at compile-time and it holds a whole number of @p StructType or @p TupleType elements whose fields are all scalars,
+ *  - each field is only accessed via <tt>lea(lea(ptr, index), field)</tt> by a @p Load or @p Store - both in host code and within the GPU kernels it is passed to, and
+ *  - it is otherwise only released.
+ * The fields are then laid out one after another, ordered by decreasing size so each one stays aligned, which also drops the padding of the original layout.
+ * Thus, neighbouring GPU threads access neighbouring addresses and loops over one field on the CPU become contiguous.
+ * Returns whether a buffer was changed.
+ */
+bool aos_to_soa(World&);
+
+}
+
+#endif
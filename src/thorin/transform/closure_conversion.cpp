@@ -1,5 +1,6 @@
 #include "thorin/continuation.h"
 #include "thorin/world.h"
+#include "thorin/analyses/callgraph.h"
 #include "thorin/analyses/verify.h"
 #include "thorin/analyses/scope.h"
 #include "thorin/analyses/free_defs.h"
@@ -17,7 +18,7 @@ public:
     void run() {
         // create a new continuation for every continuation taking a function as parameter
         std::vector<std::pair<Continuation*, Continuation*>> converted;
-        for (auto continuation : world_.copy_continuations()) {
+        for (auto continuation : bottom_up_continuations()) {
             // do not convert empty continuations or intrinsics, except graph intrinsics
             if (continuation->empty() || continuation->is_intrinsic()) {
                 new_defs_[continuation] = continuation;
@@ -56,6 +57,27 @@ public:
         }
     }
 
+    /// All continuations such that the ones in the scope of a callee come before the ones of its callers.
+    std::vector<Continuation*> bottom_up_continuations() {
+        std::vector<Continuation*> result;
+        ContinuationSet done;
+        CallGraph callgraph(world_);
+        for (auto node : callgraph.bottom_up()) {
+            Scope scope(node->continuation());
+            for (auto n : scope.f_cfg().reverse_post_order()) {
+                if (done.emplace(n->continuation()).second)
+                    result.emplace_back(n->continuation());
+            }
+        }
+
+        // unreachable and empty continuations come last
+        for (auto continuation : world_.copy_continuations()) {
+            if (done.emplace(continuation).second)
+                result.emplace_back(continuation);
+        }
+        return result;
+    }
+
     void convert_jump(Continuation* continuation) {
         // prevent conversion of calls to vectorize() or cuda(), but allow graph intrinsics
         auto callee = continuation->callee()->isa_continuation();
@@ -0,0 +1,177 @@
+#include "thorin/transform/color_slots.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// Number of elements of @p type, if it is an array - otherwise, one.
+static u64 num_elems(const Type* type) {
+    if (auto array_type = type->isa<DefiniteArrayType>())
+        return array_type->dim();
+    return 1;
+}
+
+/// Can a @p Slot of type @p type reuse the storage of a @p Slot of type @p into?
+static bool fits(const Type* into, const Type* type) {
+    if (into == type)
+        return true;
+    auto into_array = into->isa<DefiniteArrayType>();
+    auto array = type->isa<DefiniteArrayType>();
+    return into_array != nullptr && array != nullptr && into_array->elem_type() == array->elem_type() && into_array->dim() >= array->dim();
+}
+
+class SlotColoring {
+public:
+    SlotColoring(const Scope& scope)
+        : scope_(scope)
+        , cfg_(scope.f_cfg())
+        , scheduler_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    /// Returns the number of @p Slot%s merged into others.
+    size_t run();
+
+private:
+    /// All @p Slot%s sharing one storage.
+    struct Color {
+        Color(const Slot* slot, const F_CFG::Set& live)
+            : slot(slot)
+            , live(live)
+        {}
+
+        const Slot* slot;
+        F_CFG::Set live;
+    };
+
+    bool find_accesses(const Def* ptr, std::vector<const CFNode*>& blocks);
+    void reach(const std::vector<const CFNode*>& blocks, bool forward, F_CFG::Set& done) const;
+    void live_range(const std::vector<const CFNode*>& blocks, F_CFG::Set& live) const;
+    bool overlaps(const F_CFG::Set& a, const F_CFG::Set& b) const;
+
+    const Scope& scope_;
+    const F_CFG& cfg_;
+    Scheduler scheduler_;
+};
+
+size_t SlotColoring::run() {
+    DefMap<std::vector<const Slot*>> frame2slots;
+    for (auto def : scope_.defs()) {
+        if (auto slot = def->isa<Slot>())
+            frame2slots[slot->frame()].push_back(slot);
+    }
+
+    size_t num = 0;
+    for (auto& [frame, slots] : frame2slots) {
+        if (slots.size() < 2)
+            continue;
+
+        // larger slots first so the smaller ones can reuse them
+        std::sort(slots.begin(), slots.end(), [](const Slot* a, const Slot* b) {
+            auto na = num_elems(a->alloced_type()), nb = num_elems(b->alloced_type());
+            return na != nb ? na > nb : a->gid() < b->gid();
+        });
+
+        std::deque<Color> colors; // F_CFG::Set cannot be moved
+        for (auto slot : slots) {
+            std::vector<const CFNode*> blocks;
+            if (!find_accesses(slot, blocks) || blocks.empty())
+                continue;
+
+            F_CFG::Set live(cfg_);
+            live_range(blocks, live);
+            auto color = std::find_if(colors.begin(), colors.end(), [&](const Color& color) {
+                return fits(color.slot->alloced_type(), slot->alloced_type()) && !overlaps(color.live, live);
+            });
+            if (color == colors.end()) {
+                colors.emplace_back(slot, live);
+                continue;
+            }
+
+            for (auto n : cfg_.reverse_post_order()) {
+                if (live.contains(n))
+                    color->live.insert(n);
+            }
+            world().DLOG("{}: {} shares the storage of {}", scope_.entry(), slot, color->slot);
+            slot->replace(world().bitcast(slot->type(), color->slot, slot->debug()));
+            ++num;
+        }
+    }
+    return num;
+}
+
+/// Collects the blocks of all accesses through @p ptr - returns @c false if @p ptr escapes.
+bool SlotColoring::find_accesses(const Def* ptr, std::vector<const CFNode*>& blocks) {
+    for (auto use : ptr->uses()) {
+        if ((use->isa<LEA>() && use.index() == 0) || use->isa<Bitcast>()) {
+            if (!find_accesses(use.def(), blocks))
+                return false;
+        } else if (use->isa<Access>() && use.index() == 1) {
+            if (!scope_.contains(use.def()))
+                return false;
+            // dead accesses are not emitted
+            if (scheduler_.is_live(use.def()))
+                blocks.push_back(cfg_[scheduler_.smart(use.def())]);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Marks all blocks reachable from @p blocks in @p done - along the successors if @p forward, otherwise along the predecessors.
+void SlotColoring::reach(const std::vector<const CFNode*>& blocks, bool forward, F_CFG::Set& done) const {
+    std::vector<const CFNode*> stack;
+    for (auto n : blocks) {
+        if (!visit(done, n))
+            stack.push_back(n);
+    }
+    while (!stack.empty()) {
+        auto n = stack.back();
+        stack.pop_back();
+        for (auto m : forward ? cfg_.succs(n) : cfg_.preds(n)) {
+            if (!visit(done, m))
+                stack.push_back(m);
+        }
+    }
+}
+
+/// All blocks that are reachable from one of the @p blocks and from which one of the @p blocks is reachable.
+void SlotColoring::live_range(const std::vector<const CFNode*>& blocks, F_CFG::Set& live) const {
+    F_CFG::Set after(cfg_), before(cfg_);
+    reach(blocks, true, after);
+    reach(blocks, false, before);
+    for (auto n : cfg_.reverse_post_order()) {
+        if (after.contains(n) && before.contains(n))
+            live.insert(n);
+    }
+}
+
+bool SlotColoring::overlaps(const F_CFG::Set& a, const F_CFG::Set& b) const {
+    for (auto n : cfg_.reverse_post_order()) {
+        if (a.contains(n) && b.contains(n))
+            return true;
+    }
+    return false;
+}
+
+void color_slots(World& world) {
+    world.VLOG("start color_slots");
+
+    size_t num = 0;
+    Scope::for_each(world, [&](const Scope& scope) { num += SlotColoring(scope).run(); });
+    if (num != 0)
+        world.ILOG("{} slots share their storage with others", num);
+
+    world.VLOG("end color_slots");
+    debug_verify(world);
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef THORIN_TRANSFORM_COLOR_SLOTS_H
+#define THORIN_TRANSFORM_COLOR_SLOTS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Lets @p Slot%s of the same frame share their storage if their live ranges do not overlap.
+ * The live range of a @p Slot are all blocks that lie on a path from one @p Load or @p Store of it to another one.
+ * Two @p Slot%s are compatible if they have the same type or if both are arrays of the same element type - then, the smaller one reuses the larger one.
+ * @p Slot%s whose address escapes - i.e. is used by anything but @p LEA%s, @p Bitcast%s and the pointer operand of @p Load%s and @p Store%s - keep their own storage.
+ */
+void color_slots(World&);
+
+}
+
+#endif
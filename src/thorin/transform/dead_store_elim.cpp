@@ -0,0 +1,148 @@
+#include "thorin/transform/dead_store_elim.h"
+
+#include <algorithm>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/cfg.h"
+#include "thorin/analyses/looptree.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/scope.h"
+
+namespace thorin {
+
+class DeadStoreElim {
+public:
+    DeadStoreElim(const Scope& scope)
+        : scope_(scope)
+        , mssa_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    size_t run();
+
+private:
+    bool is_candidate(const Store*);
+    bool is_header(Continuation*) const;
+    bool overwrites(const Store*, const Def* ptr, bool wrapped);
+    bool is_dead(const Store*);
+
+    const Scope& scope_;
+    MemorySSA mssa_;
+};
+
+bool DeadStoreElim::is_candidate(const Store* store) {
+    auto base = mssa_.ptr_info(store->ptr()).base;
+    // memory in a non-escaping Slot or Alloc can only be read within this scope - and only via base
+    return (base->isa<Slot>() || Alloc::is_out_ptr(base)) && !mssa_.escapes(base);
+}
+
+bool DeadStoreElim::is_header(Continuation* continuation) const {
+    const auto& cfg = scope_.f_cfg();
+    auto n = cfg[continuation];
+    if (n == nullptr)
+        return false;
+    auto head = cfg.looptree()[n]->parent();
+    return !head->is_root() && std::find(head->cf_nodes().begin(), head->cf_nodes().end(), n) != head->cf_nodes().end();
+}
+
+/**
+ * Does @p store write the whole memory @p ptr points to?
+ * Once the walk has passed a loop header - it may have @p wrapped around the loop - only literal indices are guaranteed to keep their values.
+ */
+bool DeadStoreElim::overwrites(const Store* store, const Def* ptr, bool wrapped) {
+    if (wrapped && !mssa_.has_literal_path(store->ptr()))
+        return false;
+    if (mssa_.alias(store->ptr(), ptr) == AliasResult::Must)
+        return true;
+
+    auto outer = mssa_.ptr_info(store->ptr()); // copy - the lookup of ptr may rehash
+    const auto& inner = mssa_.ptr_info(ptr);
+    if (outer.base != inner.base || !outer.exact || !inner.exact || outer.path.size() > inner.path.size())
+        return false;
+    return std::equal(outer.path.begin(), outer.path.end(), inner.path.begin());
+}
+
+bool DeadStoreElim::is_dead(const Store* store) {
+    auto ptr = store->ptr();
+    std::vector<std::pair<const Def*, bool>> stack;
+    DefMap<bool> done; // mem -> wrapped
+
+    auto push = [&](const Def* mem, bool wrapped) {
+        if (mem == nullptr)
+            return;
+        if (auto param = mem->isa<Param>(); param && is_header(param->continuation()))
+            wrapped = true;
+        // revisit a state reached without wrapping - fewer stores kill on the wrapped walk
+        auto [i, inserted] = done.emplace(mem, wrapped);
+        if (inserted || (wrapped && !i->second)) {
+            i->second = wrapped;
+            stack.emplace_back(mem, wrapped);
+        }
+    };
+
+    push(store, false);
+    while (!stack.empty()) {
+        auto [mem, wrapped] = stack.back();
+        stack.pop_back();
+
+        for (const auto& user : mssa_.users(mem)) {
+            switch (user.kind) {
+                case MemorySSA::User::Access:
+                    if (auto load = user.def->isa<Load>()) {
+                        if (mssa_.alias(load->ptr(), ptr) != AliasResult::No)
+                            return false;
+                    } else if (auto other = user.def->isa<Store>()) {
+                        if (overwrites(other, ptr, wrapped))
+                            continue; // killed on this path
+                    } else if (!user.def->isa<Enter>() && !user.def->isa<Alloc>()) {
+                        return false; // Assembly
+                    }
+                    push(MemorySSA::out_mem(user.def), wrapped);
+                    break;
+                case MemorySSA::User::Jump:
+                    push(user.param, wrapped);
+                    break;
+                case MemorySSA::User::Call:
+                    // the callee cannot see non-escaping memory, but each continuation passed along may continue with it
+                    for (auto arg : user.continuation->args()) {
+                        if (auto cont = arg->isa_continuation(); cont && scope_.contains(cont))
+                            push(cont->mem_param(), wrapped);
+                    }
+                    break;
+                case MemorySSA::User::Exit:
+                    break; // memory dies
+                case MemorySSA::User::Unknown:
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t DeadStoreElim::run() {
+    std::vector<const Store*> dead;
+    for (auto access : mssa_.accesses()) {
+        if (auto store = access->isa<Store>(); store && is_candidate(store) && is_dead(store))
+            dead.emplace_back(store);
+    }
+
+    // a store is only dead if nobody reads it - this doesn't depend on other dead stores, so remove them all at once
+    for (auto store : dead) {
+        world().DLOG("dead store: {}", store);
+        store->replace(store->mem());
+    }
+
+    return dead.size();
+}
+
+void dead_store_elim(World& world) {
+    world.VLOG("start dead_store_elim");
+    size_t num = 0;
+    Scope::for_each(world, [&](const Scope& scope) { num += DeadStoreElim(scope).run(); });
+    world.VLOG("removed {} dead stores", num);
+    world.VLOG("end dead_store_elim");
+}
+
+}
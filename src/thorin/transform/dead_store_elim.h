@@ -0,0 +1,17 @@
+#ifndef THORIN_TRANSFORM_DEAD_STORE_ELIM_H
+#define THORIN_TRANSFORM_DEAD_STORE_ELIM_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Removes @p Store%s to @p Slot%s and @p Alloc memory which do not escape, if the stored value is never read:
+ * Either each path from the @p Store overwrites the same location before reading it, or the memory dies when leaving the function.
+ * This works across @p Continuation%s by following the memory through the mem @p Param%s (see @p MemorySSA).
+ */
+void dead_store_elim(World&);
+
+}
+
+#endif
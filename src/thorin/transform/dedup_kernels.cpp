@@ -0,0 +1,88 @@
+#include "thorin/transform/dedup_kernels.h"
+
+#include <unordered_map>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/scope_hash.h"
+
+namespace thorin {
+
+/// Returns the GPU backend @p kernel is exclusively launched on or @p Intrinsic::None.
+static Intrinsic gpu_intrinsic(Continuation* kernel) {
+    auto result = Intrinsic::None;
+    bool ok = !kernel->empty() && kernel->is_internal();
+    for (auto use : kernel->uses()) {
+        auto global = use->isa<Global>();
+        if (!global) {
+            ok = false;
+            continue;
+        }
+
+        for (auto guse : global->uses()) {
+            auto continuation = guse->isa_continuation();
+            auto callee = continuation ? continuation->callee()->isa_continuation() : nullptr;
+            if (!callee || guse.index() == 0) {
+                ok = false;
+                continue;
+            }
+
+            auto intrinsic = callee->intrinsic();
+            // HLS kernels are configured for the buffer sizes of their launch site
+            ok &= intrinsic == Intrinsic::CUDA || intrinsic == Intrinsic::NVVM || intrinsic == Intrinsic::OpenCL || intrinsic == Intrinsic::AMDGPU;
+            ok &= result == Intrinsic::None || result == intrinsic;
+            result = intrinsic;
+        }
+    }
+    return ok ? result : Intrinsic::None;
+}
+
+void dedup_kernels(World& world) {
+    world.VLOG("start dedup_kernels");
+
+    struct Kernel {
+        Intrinsic intrinsic;
+        std::unique_ptr<Scope> scope;
+    };
+
+    std::vector<Continuation*> candidates;
+    for (auto continuation : world.continuations()) {
+        if (is_passed_to_accelerator(continuation))
+            candidates.push_back(continuation);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](Continuation* a, Continuation* b) { return a->gid() < b->gid(); });
+
+    std::unordered_map<hash_t, std::vector<Kernel>> hash2kernels;
+    size_t num = 0;
+    for (auto continuation : candidates) {
+        auto intrinsic = gpu_intrinsic(continuation);
+        if (intrinsic == Intrinsic::None)
+            continue;
+
+        auto scope = std::make_unique<Scope>(continuation);
+        auto& kernels = hash2kernels[structural_hash(*scope)];
+        auto i = std::find_if(kernels.begin(), kernels.end(), [&](const Kernel& kernel) {
+            return kernel.intrinsic == intrinsic && structurally_equal(*kernel.scope, *scope);
+        });
+
+        if (i == kernels.end()) {
+            kernels.push_back({intrinsic, std::move(scope)});
+            continue;
+        }
+
+        auto rep = i->scope->entry();
+        auto global = rep->uses().begin()->def();
+        world.DLOG("kernel {} is a duplicate of {}", continuation, rep);
+        for (auto use : continuation->copy_uses())
+            use->replace(global);
+        ++num;
+    }
+
+    world.VLOG("merged {} duplicate kernels", num);
+    world.VLOG("end dedup_kernels");
+    if (num != 0)
+        world.cleanup();
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef THORIN_TRANSFORM_DEDUP_KERNELS_H
+#define THORIN_TRANSFORM_DEDUP_KERNELS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Merges structurally equal kernels which are launched on the same GPU backend.
+ * @p clone_bodies clones a kernel for each launch site; after partial evaluation many of these clones are still identical.
+ * All launch sites of a duplicate then refer to a single representative, so each kernel is imported and emitted only once.
+ * Must run after @p lift_builtins.
+ */
+void dedup_kernels(World&);
+
+}
+
+#endif
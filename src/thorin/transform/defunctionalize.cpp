@@ -0,0 +1,329 @@
+#include "thorin/transform/defunctionalize.h"
+
+#include <algorithm>
+#include <map>
+
+#include "thorin/continuation.h"
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// Params with more targets than this keep their closure.
+static const size_t max_targets = 4;
+
+/**
+ * Returns the lifted continuation called by @p wrapper (see @p closure_conversion) or @c nullptr,
+ * if @p wrapper does not have this shape - e.g. because the lifted continuation has been inlined into it.
+ */
+static Continuation* lifted(Continuation* wrapper) {
+    if (wrapper->empty() || wrapper->num_params() == 0)
+        return nullptr;
+    auto lifted = wrapper->callee()->isa_continuation();
+    if (lifted == nullptr || lifted->empty() || lifted->num_params() + 1 < wrapper->num_params())
+        return nullptr;
+    return lifted;
+}
+
+/// Can we call the target of @p closure directly? Either via its lifted continuation or via its wrapper with an environment passed by value.
+static bool is_direct(const Closure* closure) {
+    auto wrapper = closure->op(0)->isa_continuation();
+    return wrapper != nullptr && (lifted(wrapper) != nullptr || is_thin(closure->op(1)->type()));
+}
+
+class Defunctionalization {
+public:
+    Defunctionalization(World& world)
+        : world_(world)
+    {}
+
+    World& world() const { return world_; }
+    void run();
+
+private:
+    bool is_known(Continuation*) const;
+    void analyze();
+    bool invalidate(const Param*);
+    const VariantType* variant_type(const Param*);
+    Continuation* rewrite(Continuation*);
+    void dispatch(Continuation* caller, const Param* param);
+
+    World& world_;
+    ParamMap<std::vector<const Closure*>> closures_; ///< Closures passed to a param.
+    ParamMap<std::vector<const Param*>> sources_;    ///< Params passed to a param.
+    ParamMap<std::vector<const Param*>> dests_;      ///< Params a param is passed to.
+    ParamMap<std::vector<Continuation*>> targets_;   ///< Wrappers of all closures flowing into a param, sorted by gid.
+    ParamSet invalid_;
+    Param2Param param2variant_;
+    std::map<std::vector<Continuation*>, const VariantType*> variant_types_;
+};
+
+/// Do we know all call sites of @p continuation?
+bool Defunctionalization::is_known(Continuation* continuation) const {
+    if (continuation->empty() || continuation->is_exported() || continuation->is_intrinsic())
+        return false;
+    for (auto use : continuation->uses()) {
+        if (!use->isa_continuation() || use.index() != 0)
+            return false;
+    }
+    return true;
+}
+
+bool Defunctionalization::invalidate(const Param* param) {
+    if (!invalid_.emplace(param).second)
+        return false;
+    // a param may neither receive nor pass on variants from/to params which keep their closures
+    for (auto src : sources_[param])
+        invalidate(src);
+    for (auto dst : dests_[param])
+        invalidate(dst);
+    return true;
+}
+
+void Defunctionalization::analyze() {
+    std::vector<const Param*> params;
+    for (auto continuation : world().continuations()) {
+        for (auto param : continuation->params()) {
+            if (!param->type()->isa<ClosureType>())
+                continue;
+            params.emplace_back(param);
+            if (!is_known(continuation))
+                invalid_.emplace(param);
+        }
+    }
+
+    // collect what flows into each param and check that it is only called or passed on
+    for (auto param : params) {
+        if (invalid_.contains(param))
+            continue;
+
+        for (auto use : param->continuation()->uses()) {
+            auto arg = use->as_continuation()->arg(param->index());
+            if (auto closure = arg->isa<Closure>(); closure && is_direct(closure)) {
+                closures_[param].emplace_back(closure);
+            } else if (auto src = arg->isa<Param>(); src && src->type() == param->type()) {
+                sources_[param].emplace_back(src);
+                dests_[src].emplace_back(param);
+            } else {
+                invalid_.emplace(param);
+            }
+        }
+
+        for (auto use : param->uses()) {
+            auto continuation = use->isa_continuation();
+            if (continuation == nullptr)
+                invalid_.emplace(param);
+            else if (use.index() != 0 && (!continuation->callee()->isa_continuation() || !is_known(continuation->callee()->as_continuation())))
+                invalid_.emplace(param);
+        }
+    }
+
+    for (auto param : params) {
+        if (invalid_.erase(param) != 0)
+            invalidate(param);
+    }
+
+    // propagate the targets through the params
+    for (auto param : params) {
+        auto& targets = targets_[param];
+        for (auto closure : closures_[param])
+            targets.emplace_back(closure->op(0)->as_continuation());
+    }
+
+    for (bool todo = true; todo;) {
+        todo = false;
+        for (auto param : params) {
+            auto& targets = targets_[param];
+            for (auto src : sources_[param]) {
+                for (auto target : targets_[src]) {
+                    if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                        targets.emplace_back(target);
+                        todo = true;
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto param : params) {
+        auto& targets = targets_[param];
+        std::sort(targets.begin(), targets.end(), [](Continuation* a, Continuation* b) { return a->gid() < b->gid(); });
+        if (targets.empty() || targets.size() > max_targets)
+            invalidate(param);
+    }
+
+    // params connected with each other must agree on the variant type
+    for (bool todo = true; todo;) {
+        todo = false;
+        for (auto param : params) {
+            if (invalid_.contains(param))
+                continue;
+            for (auto src : sources_[param]) {
+                if (targets_[src] != targets_[param])
+                    todo |= invalidate(param);
+            }
+        }
+    }
+}
+
+const VariantType* Defunctionalization::variant_type(const Param* param) {
+    const auto& targets = targets_[param];
+    auto& type = variant_types_[targets];
+    if (type == nullptr) {
+        type = world().variant_type("closure_" + param->continuation()->name(), targets.size());
+        for (size_t i = 0, e = targets.size(); i != e; ++i) {
+            // the environment of the wrapper, see closure_conversion
+            auto closure = std::find_if(closures_[param].begin(), closures_[param].end(), [&](const Closure* c) { return c->op(0) == targets[i]; });
+            const Type* env_type = nullptr;
+            if (closure != closures_[param].end()) {
+                env_type = (*closure)->op(1)->type();
+            } else {
+                // the closure reaches this param via other params
+                for (auto& [_, closures] : closures_) {
+                    for (auto c : closures) {
+                        if (c->op(0) == targets[i])
+                            env_type = c->op(1)->type();
+                    }
+                }
+            }
+            type->set(i, env_type);
+            type->set_op_name(i, targets[i]->name());
+        }
+    }
+    return type;
+}
+
+Continuation* Defunctionalization::rewrite(Continuation* continuation) {
+    Array<const Type*> param_types(continuation->num_params());
+    for (size_t i = 0, e = continuation->num_params(); i != e; ++i) {
+        auto param = continuation->param(i);
+        bool variant = param->type()->isa<ClosureType>() && !invalid_.contains(param);
+        param_types[i] = variant ? variant_type(param) : param->type();
+    }
+
+    auto new_continuation = world().continuation(world().fn_type(param_types), continuation->debug());
+    new_continuation->jump(continuation->callee(), continuation->args(), continuation->debug());
+    continuation->destroy_body();
+
+    for (size_t i = 0, e = continuation->num_params(); i != e; ++i) {
+        auto param = continuation->param(i);
+        auto new_param = new_continuation->param(i);
+        new_param->set_name(param->name());
+        if (param->type() == new_param->type())
+            param->replace(new_param);
+        else
+            param2variant_[param] = new_param;
+    }
+
+    return new_continuation;
+}
+
+void Defunctionalization::dispatch(Continuation* caller, const Param* param) {
+    const auto& targets = targets_[param];
+    auto variant = param2variant_.find(param)->second;
+    Array<const Def*> args(caller->args());
+
+    auto call = [&](Continuation* continuation, size_t i) {
+        auto wrapper = targets[i];
+        auto env = world().variant_extract(variant, i, caller->debug());
+        auto callee = lifted(wrapper);
+        if (callee == nullptr) {
+            // pass the environment by value just like the code generator does
+            auto env_type = Closure::environment_type(world());
+            auto new_env = is_type_unit(env->type()) ? world().bottom(env_type) : world().cast(env_type, env, caller->debug());
+            Array<const Def*> new_args(args.size() + 1);
+            std::copy(args.begin(), args.end(), new_args.begin());
+            new_args.back() = new_env;
+            return continuation->jump(wrapper, new_args, caller->debug());
+        }
+
+        auto num_free = callee->num_params() - (wrapper->num_params() - 1);
+        Array<const Def*> new_args(callee->num_params());
+        std::copy(args.begin(), args.end(), new_args.begin());
+        if (num_free == 1) {
+            new_args.back() = env;
+        } else {
+            for (size_t j = 0; j != num_free; ++j)
+                new_args[args.size() + j] = world().extract(env, j, caller->debug());
+        }
+        continuation->jump(callee, new_args, caller->debug());
+    };
+
+    if (targets.size() == 1)
+        return call(caller, 0);
+
+    Array<Continuation*> cases(targets.size());
+    Array<const Def*> patterns(targets.size() - 1);
+    for (size_t i = 0, e = targets.size(); i != e; ++i) {
+        cases[i] = world().continuation(world().fn_type(), {"case_" + targets[i]->name()});
+        call(cases[i], i);
+        if (i != e - 1)
+            patterns[i] = world().literal_qu64(i, caller->debug());
+    }
+
+    caller->match(world().variant_index(variant, caller->debug()), cases.back(), patterns, cases.skip_back(), caller->debug());
+}
+
+void Defunctionalization::run() {
+    analyze();
+
+    std::vector<std::pair<Continuation*, Continuation*>> rewritten;
+    for (auto continuation : world().copy_continuations()) {
+        for (auto param : continuation->params()) {
+            if (param->type()->isa<ClosureType>() && !invalid_.contains(param)) {
+                rewritten.emplace_back(continuation, rewrite(continuation));
+                break;
+            }
+        }
+    }
+
+    if (rewritten.empty())
+        return;
+
+    // calls through variant params
+    for (auto [_, new_continuation] : rewritten) {
+        for (auto [param, variant] : param2variant_) {
+            if (variant->continuation() != new_continuation)
+                continue;
+            for (auto use : param->copy_uses()) {
+                if (use.index() == 0)
+                    dispatch(use->as_continuation(), param);
+            }
+        }
+    }
+
+    // calls to rewritten continuations
+    for (auto [old_continuation, new_continuation] : rewritten) {
+        world().DLOG("defunctionalized {}", new_continuation);
+        for (auto use : old_continuation->copy_uses()) {
+            auto caller = use->as_continuation();
+            Array<const Def*> args(caller->args());
+            for (size_t i = 0, e = args.size(); i != e; ++i) {
+                auto variant_type = new_continuation->param(i)->type()->isa<VariantType>();
+                if (variant_type == nullptr || args[i]->type() == variant_type)
+                    continue;
+                if (auto closure = args[i]->isa<Closure>()) {
+                    const auto& targets = targets_[old_continuation->param(i)];
+                    auto index = std::find(targets.begin(), targets.end(), closure->op(0)) - targets.begin();
+                    args[i] = world().variant(variant_type, closure->op(1), index, closure->debug());
+                } else {
+                    args[i] = param2variant_[args[i]->as<Param>()];
+                }
+            }
+            caller->jump(new_continuation, args, caller->debug());
+        }
+        old_continuation->make_internal();
+    }
+
+    debug_verify(world());
+    world().cleanup();
+}
+
+void defunctionalize(World& world) {
+    world.VLOG("start defunctionalize");
+    Defunctionalization(world).run();
+    world.VLOG("end defunctionalize");
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef THORIN_TRANSFORM_DEFUNCTIONALIZE_H
+#define THORIN_TRANSFORM_DEFUNCTIONALIZE_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Replaces closure-typed @p Param%s with a small known set of possible targets by a @p VariantType.
+ * Each alternative of the variant holds the environment of one target.
+ * Calls through such a @p Param become a @c match on the variant index with direct calls to the lifted targets.
+ * Must run after @p closure_conversion.
+ */
+void defunctionalize(World&);
+
+}
+
+#endif
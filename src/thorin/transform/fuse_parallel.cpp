@@ -0,0 +1,223 @@
+#include "thorin/transform/fuse_parallel.h"
+
+#include <algorithm>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/cfg.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+#include "thorin/transform/mangle.h"
+
+namespace thorin {
+
+enum {
+    PAR_ARG_MEM,
+    PAR_ARG_NUMTHREADS,
+    PAR_ARG_LOWER,
+    PAR_ARG_UPPER,
+    PAR_ARG_BODY,
+    PAR_ARG_RETURN,
+    PAR_NUM_ARGS
+};
+
+/// The lifted body of the @c parallel call issued by @p continuation - @c nullptr if there is none.
+static Continuation* parallel_body(Continuation* continuation) {
+    auto callee = continuation->callee()->isa_continuation();
+    if (callee == nullptr || callee->intrinsic() != Intrinsic::Parallel || continuation->num_args() < PAR_NUM_ARGS)
+        return nullptr;
+    auto global = continuation->arg(PAR_ARG_BODY)->isa<Global>();
+    auto body = global != nullptr ? global->init()->isa_continuation() : nullptr;
+    return body != nullptr && !body->empty() ? body : nullptr;
+}
+
+/// Does @p def yield a distinct value for each value of @p index?
+static bool is_injective(const Def* def, const Def* index) {
+    if (def == index)
+        return true;
+    if (auto arithop = def->isa<ArithOp>()) {
+        auto tag = arithop->arithop_tag();
+        if (tag == ArithOp_add || tag == ArithOp_sub || tag == ArithOp_xor) {
+            if (arithop->lhs()->isa<PrimLit>())
+                return is_injective(arithop->rhs(), index);
+            if (arithop->rhs()->isa<PrimLit>())
+                return is_injective(arithop->lhs(), index);
+        }
+    }
+    return false;
+}
+
+class ParallelFusion {
+public:
+    ParallelFusion(const Scope& scope)
+        : scope_(scope)
+        , mssa_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    bool fuse(Continuation* first);
+
+private:
+    struct MemAccess {
+        const Def* ptr;
+        bool is_store;
+    };
+
+    bool collect(Continuation* call, Continuation* body, const Def* index, std::vector<MemAccess>& accesses);
+    bool same_element(const Def* a, const Def* b, const Def* index);
+    void outline(Continuation* call, Continuation* body, Continuation* fused, Continuation* entry, const Def* ret, const DefMap<size_t>& free2index);
+
+    const Scope& scope_;
+    MemorySSA mssa_;
+};
+
+/**
+ * Collects the memory accesses of @p body called by @p call.
+ * Their pointers are expressed in terms of the arguments of @p call and @p index as the loop index so that both bodies are comparable.
+ * Returns @c false if @p body has effects beyond plain loads and stores.
+ */
+bool ParallelFusion::collect(Continuation* call, Continuation* body, const Def* index, std::vector<MemAccess>& accesses) {
+    Scope scope(body);
+    const auto& cfg = scope.f_cfg();
+    for (auto n : cfg.reverse_post_order()) {
+        if (n == cfg.exit())
+            continue;
+        auto callee = n->continuation()->callee();
+        auto continuation = callee->isa_continuation();
+        if (callee != body->param(2) && (continuation == nullptr || (continuation->intrinsic() != Intrinsic::Branch && !scope.contains(continuation))))
+            return false;
+    }
+
+    Def2Def old2new;
+    old2new[body->param(1)] = index;
+    for (size_t i = PAR_NUM_ARGS, e = call->num_args(); i != e; ++i)
+        old2new[body->param(i - PAR_NUM_ARGS + 3)] = call->arg(i);
+
+    for (auto def : scope.defs()) {
+        if (auto access = def->isa<Access>()) {
+            // slots allocated within the body are private to each iteration
+            auto base = mssa_.ptr_info(access->ptr()).base;
+            if (base->isa<Slot>() && scope.contains(base))
+                continue;
+            accesses.push_back({instantiate(old2new, access->ptr()), access->isa<Store>() != nullptr});
+        } else if (def->isa<MemOp>() && !def->isa<Enter>() && !def->isa<Join>()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Do @p a and @p b refer to the same element which is distinct in each iteration?
+bool ParallelFusion::same_element(const Def* a, const Def* b, const Def* index) {
+    if (a != b)
+        return false;
+    const auto& info = mssa_.ptr_info(a);
+    return info.exact && std::any_of(info.path.begin(), info.path.end(), [&](const Def* def) { return is_injective(def, index); });
+}
+
+/// Lets @p entry run a copy of @p body within @p fused whose free values are passed at the positions in @p free2index.
+void ParallelFusion::outline(Continuation* call, Continuation* body, Continuation* fused, Continuation* entry, const Def* ret, const DefMap<size_t>& free2index) {
+    Def2Def old2new;
+    old2new[body->param(0)] = entry->param(0);
+    old2new[body->param(1)] = fused->param(1);
+    old2new[body->param(2)] = ret;
+    for (size_t i = PAR_NUM_ARGS, e = call->num_args(); i != e; ++i)
+        old2new[body->param(i - PAR_NUM_ARGS + 3)] = fused->param(free2index.find(call->arg(i))->second + 3);
+
+    Scope scope(body);
+    const auto& cfg = scope.f_cfg();
+    std::vector<Continuation*> continuations;
+    for (auto n : cfg.reverse_post_order().skip_front()) {
+        if (n != cfg.exit())
+            continuations.push_back(n->continuation());
+    }
+    clone(old2new, continuations);
+    clone_body(old2new, body, entry);
+}
+
+bool ParallelFusion::fuse(Continuation* first) {
+    auto body1 = parallel_body(first);
+    if (body1 == nullptr)
+        return false;
+    auto second = first->arg(PAR_ARG_RETURN)->isa_continuation();
+    auto body2 = second != nullptr && second->num_params() == 1 ? parallel_body(second) : nullptr;
+    // nothing but the second call may depend on the memory after the first one
+    if (body2 == nullptr || second->arg(PAR_ARG_MEM) != second->param(0) || second->param(0)->num_uses() != 1)
+        return false;
+    for (size_t i = PAR_ARG_NUMTHREADS; i != PAR_ARG_BODY; ++i) {
+        if (first->arg(i) != second->arg(i))
+            return false;
+    }
+    if (body1->param(1)->type() != body2->param(1)->type())
+        return false;
+
+    auto index = body1->param(1);
+    std::vector<MemAccess> accesses1, accesses2;
+    if (!collect(first, body1, index, accesses1) || !collect(second, body2, index, accesses2))
+        return false;
+    for (const auto& a : accesses1) {
+        for (const auto& b : accesses2) {
+            if ((a.is_store || b.is_store) && mssa_.alias(a.ptr, b.ptr) != AliasResult::No && !same_element(a.ptr, b.ptr, index))
+                return false;
+        }
+    }
+
+    // fused(mem, index, return, free values of both bodies): body1 returns to join which continues with body2
+    std::vector<const Def*> frees;
+    DefMap<size_t> free2index;
+    for (auto call : {first, second}) {
+        for (auto arg : call->args().skip_front(PAR_NUM_ARGS)) {
+            if (free2index.emplace(arg, frees.size()).second)
+                frees.push_back(arg);
+        }
+    }
+
+    auto return_type = world().fn_type({world().mem_type()});
+    Array<const Type*> param_types(frees.size() + 3);
+    param_types[0] = world().mem_type();
+    param_types[1] = index->type();
+    param_types[2] = return_type;
+    for (size_t i = 0, e = frees.size(); i != e; ++i)
+        param_types[i + 3] = frees[i]->type();
+    auto fused = world().continuation(world().fn_type(param_types), body1->debug_history());
+    auto join = world().continuation(return_type, body2->debug_history());
+    outline(first, body1, fused, fused, join, free2index);
+    outline(second, body2, fused, join, fused->param(2), free2index);
+
+    Array<const Def*> args(frees.size() + PAR_NUM_ARGS);
+    for (size_t i = 0; i != PAR_ARG_BODY; ++i)
+        args[i] = first->arg(i);
+    args[PAR_ARG_BODY] = world().global(fused, false, fused->debug());
+    args[PAR_ARG_RETURN] = second->arg(PAR_ARG_RETURN);
+    std::copy(frees.begin(), frees.end(), args.begin() + PAR_NUM_ARGS);
+
+    auto callee = first->callee()->as_continuation();
+    auto fn_type = world().fn_type(Array<const Type*>(args.size(), [&](auto i) { return args[i]->type(); }));
+    auto parallel = world().continuation(fn_type, callee->attributes(), callee->debug());
+    first->jump(parallel, args, first->debug());
+
+    world().ILOG("fused parallel bodies {} and {}", body1, body2);
+    return true;
+}
+
+void fuse_parallel(World& world) {
+    world.VLOG("start fuse_parallel");
+
+    bool todo = false;
+    Scope::for_each(world, [&](const Scope& scope) {
+        ParallelFusion fusion(scope);
+        for (auto n : scope.f_cfg().reverse_post_order()) {
+            // chains of calls are fused pairwise
+            while (fusion.fuse(n->continuation()))
+                todo = true;
+        }
+    });
+    if (todo)
+        world.cleanup();
+
+    world.VLOG("end fuse_parallel");
+    debug_verify(world);
+}
+
+}
@@ -0,0 +1,21 @@
+#ifndef THORIN_TRANSFORM_FUSE_PARALLEL_H
+#define THORIN_TRANSFORM_FUSE_PARALLEL_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Fuses back-to-back calls of the @c parallel intrinsic into a single one - this saves a fork/join and a pass over memory.
+ * The return @p Continuation of the first call must immediately issue the second call with the same number of threads
+ * and the same <tt>[lower, upper)</tt> range.
+ * Both bodies must only touch memory that the other one does not write, or the very same element in the same iteration -
+ * that is, an element whose index is a function of the loop index which yields a distinct element in each iteration.
+ * Bodies that call functions or allocate memory on the heap are left alone.
+ * The fused body runs the first body and then the second one - both must have been lifted by @p lift_builtins before.
+ */
+void fuse_parallel(World&);
+
+}
+
+#endif
@@ -0,0 +1,305 @@
+#include "thorin/transform/hoist_loads.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/domtree.h"
+#include "thorin/analyses/looptree.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/util/utility.h"
+
+namespace thorin {
+
+/// Replaces all uses of @p load's outputs without creating new nodes.
+static void replace_load(const Load* load, const Def* mem, const Def* val) {
+    for (auto use : load->copy_uses()) {
+        if (Load::is_out_mem(use.def()))
+            use->replace(mem);
+        else if (Load::is_out_val(use.def()))
+            use->replace(val);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+class LoadForwarding {
+public:
+    LoadForwarding(const Scope& scope)
+        : scope_(scope)
+        , mssa_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    size_t run();
+
+private:
+    const Def* available(const Load*);
+
+    const Scope& scope_;
+    MemorySSA mssa_;
+};
+
+/**
+ * Walks the memory chain upwards from @p load until each path reaches a @p Load of or a @p Store to the same location.
+ * Returns the loaded or stored value, if it is the same on all paths, @c nullptr otherwise.
+ */
+const Def* LoadForwarding::available(const Load* load) {
+    auto ptr = load->ptr();
+    auto type = load->out_val_type();
+    const Def* value = nullptr;
+    std::vector<const Def*> stack;
+    DefSet done;
+
+    auto push = [&](const Def* mem) {
+        auto access = MemorySSA::access(mem);
+        if (done.emplace(access).second)
+            stack.emplace_back(access);
+    };
+
+    auto found = [&](const Def* def) {
+        if (value != nullptr && value != def)
+            return false;
+        value = def;
+        return true;
+    };
+
+    push(load->mem());
+    while (!stack.empty()) {
+        auto access = stack.back();
+        stack.pop_back();
+
+        // we reached ourselves via a loop: the value is the same as on the other paths
+        if (access == load)
+            continue;
+
+        if (auto other = access->isa<Load>(); other && other->out_val_type() == type && mssa_.alias(other->ptr(), ptr) == AliasResult::Must) {
+            if (!found(other->out_val()))
+                return nullptr;
+            continue;
+        }
+
+        if (auto store = access->isa<Store>(); store && store->val()->type() == type && mssa_.alias(store->ptr(), ptr) == AliasResult::Must) {
+            if (!found(store->val()))
+                return nullptr;
+            continue;
+        }
+
+        if (mssa_.may_clobber(access, ptr))
+            return nullptr;
+
+        if (auto join = access->isa<Join>()) {
+            for (auto mem : join->mems())
+                push(mem);
+        } else if (auto memop = access->isa<MemOp>()) {
+            push(memop->mem());
+        } else if (auto param = access->isa<Param>()) {
+            if (mssa_.kind(param) == MemorySSA::ParamKind::Phi) {
+                // alias is only Must within an iteration - but the entry into a loop cannot reach a pointer that depends on the header's params
+                if (mssa_.incoming(param).empty())
+                    return nullptr;
+                for (auto in : mssa_.incoming(param))
+                    push(in);
+            } else {
+                assert(mssa_.kind(param) == MemorySSA::ParamKind::Call);
+                for (auto call : mssa_.calls(param)) {
+                    for (auto arg : call->args()) {
+                        if (is_mem(arg))
+                            push(arg);
+                    }
+                }
+            }
+        } else {
+            return nullptr;
+        }
+    }
+
+    return value;
+}
+
+size_t LoadForwarding::run() {
+    std::vector<std::pair<const Load*, const Def*>> todo;
+    for (auto access : mssa_.accesses()) {
+        if (auto load = access->isa<Load>()) {
+            if (auto value = available(load))
+                todo.emplace_back(load, value);
+        }
+    }
+
+    // a value may stem from a Load we replace as well - Tracker follows the chain of replacements
+    for (auto [load, value] : todo) {
+        Tracker val = value;
+        if (Load::is_out_val(val) == load)
+            continue;
+        world().DLOG("forward {} to {}", load, val);
+        replace_load(load, load->mem(), val);
+    }
+
+    return todo.size();
+}
+
+//------------------------------------------------------------------------------
+
+class LoopInvariantLoads {
+public:
+    LoopInvariantLoads(const Scope& scope)
+        : scope_(scope)
+        , cfg_(scope.f_cfg())
+        , scheduler_(scope)
+        , mssa_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    /// Hoists the loads of the innermost loop with hoistable loads; returns whether something changed.
+    bool run();
+
+private:
+    using Head = LoopTree<true>::Head;
+
+    const CFNode* block(const Def*);
+    bool contains(const Head*, const CFNode*) const;
+    bool hoist(const Head*);
+    bool dominates(const CFNode*, const CFNode*) const;
+    bool is_invariant(const Head*, const Load*);
+    bool is_safe(const Head*, const Load*);
+
+    const Scope& scope_;
+    const F_CFG& cfg_;
+    Scheduler scheduler_;
+    MemorySSA mssa_;
+};
+
+/// Where the code generator places @p def - @c nullptr, if @p def is dead.
+const CFNode* LoopInvariantLoads::block(const Def* def) {
+    return scheduler_.is_live(def) ? cfg_[scheduler_.smart(def)] : nullptr;
+}
+
+bool LoopInvariantLoads::contains(const Head* head, const CFNode* n) const {
+    if (n == nullptr)
+        return false;
+    for (auto parent = cfg_.looptree()[n]->parent(); parent != nullptr; parent = parent->parent()) {
+        if (parent == head)
+            return true;
+    }
+    return false;
+}
+
+bool LoopInvariantLoads::dominates(const CFNode* a, const CFNode* b) const {
+    const auto& domtree = cfg_.domtree();
+    while (domtree.depth(b) > domtree.depth(a))
+        b = domtree.idom(b);
+    return a == b;
+}
+
+bool LoopInvariantLoads::is_invariant(const Head* head, const Load* load) {
+    auto ptr = load->ptr();
+    if (contains(head, cfg_[scheduler_.early(ptr)]))
+        return false;
+
+    for (auto access : mssa_.accesses()) {
+        if (access != load && contains(head, block(access)) && mssa_.may_clobber(access, ptr))
+            return false;
+    }
+
+    for (auto n : cfg_.reverse_post_order()) {
+        if (auto mem = n->continuation()->mem_param(); mem && contains(head, n) && mssa_.kind(mem) == MemorySSA::ParamKind::Call && mssa_.call_may_clobber(ptr))
+            return false;
+    }
+
+    return true;
+}
+
+bool LoopInvariantLoads::is_safe(const Head* head, const Load* load) {
+    // identified objects exist as long as their pointer does
+    if (MemorySSA::is_identified(mssa_.ptr_info(load->ptr()).base))
+        return true;
+
+    // otherwise, the load must execute in each iteration that leaves the loop
+    auto n = block(load);
+    for (auto m : cfg_.reverse_post_order()) {
+        if (!contains(head, m))
+            continue;
+        for (auto succ : cfg_.succs(m)) {
+            if (!contains(head, succ) && !dominates(n, m))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool LoopInvariantLoads::hoist(const Head* head) {
+    if (head->num_cf_nodes() != 1)
+        return false;
+
+    auto header = head->cf_nodes().front();
+    auto mem_param = header->continuation()->mem_param();
+    if (mem_param == nullptr)
+        return false;
+
+    Continuation* preheader = nullptr;
+    for (auto pred : cfg_.preds(header)) {
+        if (contains(head, pred))
+            continue;
+        if (preheader != nullptr || pred->continuation()->callee() != header->continuation())
+            return false;
+        preheader = pred->continuation();
+    }
+    if (preheader == nullptr)
+        return false;
+
+    std::vector<const Load*> loads;
+    for (auto access : mssa_.accesses()) {
+        if (auto load = access->isa<Load>()) {
+            if (contains(head, block(load)) && is_invariant(head, load) && is_safe(head, load))
+                loads.emplace_back(load);
+        }
+    }
+
+    auto index = mem_param->index();
+    for (auto load : loads) {
+        world().DLOG("hoist {} from {} to {}", load, header->continuation(), preheader);
+        auto hoisted = world().load(preheader->arg(index), load->ptr(), load->debug());
+        preheader->update_arg(index, world().extract(hoisted, 0_u32));
+        replace_load(load, load->mem(), world().extract(hoisted, 1));
+    }
+
+    return !loads.empty();
+}
+
+bool LoopInvariantLoads::run() {
+    // inner loops first so loads can bubble up through several loops in subsequent rounds
+    std::vector<const Head*> heads;
+    post_order_walk<const LoopTree<true>::Base*>(cfg_.looptree().root(),
+        [&](const LoopTree<true>::Base* n) { return n->isa<Head>() != nullptr; },
+        [&](const LoopTree<true>::Base* n) {
+            std::vector<const LoopTree<true>::Base*> children;
+            for (const auto& child : n->as<Head>()->children())
+                children.emplace_back(child.get());
+            return children;
+        },
+        [&](const LoopTree<true>::Base* n) {
+            if (auto head = n->as<Head>(); !head->is_root())
+                heads.emplace_back(head);
+        });
+
+    for (auto head : heads) {
+        if (hoist(head))
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+void hoist_loads(World& world) {
+    world.VLOG("start hoist_loads");
+    Scope::for_each(world, [&](Scope& scope) {
+        if (LoadForwarding(scope).run() != 0)
+            scope.update();
+        while (LoopInvariantLoads(scope).run())
+            scope.update();
+    });
+    world.VLOG("end hoist_loads");
+}
+
+}
@@ -0,0 +1,19 @@
+#ifndef THORIN_TRANSFORM_HOIST_LOADS_H
+#define THORIN_TRANSFORM_HOIST_LOADS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Removes redundant @p Load%s and hoists loop-invariant @p Load%s based on @p MemorySSA.
+ * - A @p Load is replaced by an earlier @p Load of the same location or by the value of a @p Store to it,
+ *   if this value reaches the @p Load on all paths without any clobbering access in between - even across @p Continuation%s.
+ * - A @p Load within a loop is hoisted to the loop's preheader, if its pointer is loop-invariant, no access within the loop may clobber it,
+ *   and it is safe to execute the @p Load speculatively.
+ */
+void hoist_loads(World&);
+
+}
+
+#endif
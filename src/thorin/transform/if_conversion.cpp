@@ -0,0 +1,185 @@
+#include "thorin/transform/if_conversion.h"
+
+#include <algorithm>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+IfConversionConfig IfConversionConfig::get(Target target) {
+    switch (target) {
+        // about what a mispredicted branch costs
+        case Target::CPU: return {4};
+        // divergent warps execute both arms anyway
+        case Target::GPU: return {16};
+        // a select is a multiplexer whereas a branch costs extra states
+        case Target::HLS: return {8};
+    }
+    THORIN_UNREACHABLE;
+}
+
+/// Can @p ptr be dereferenced no matter which path was taken?
+static bool is_dereferenceable(const Def* ptr) {
+    if (ptr->isa<Slot>() || ptr->isa<Global>())
+        return true;
+
+    if (auto lea = ptr->isa<LEA>()) {
+        auto pointee = lea->ptr_pointee();
+        if (auto array_type = pointee->isa<DefiniteArrayType>()) {
+            auto index = lea->index()->isa<PrimLit>();
+            return index != nullptr && primlit_value<uint64_t>(index) < array_type->dim() && is_dereferenceable(lea->ptr());
+        }
+        return (pointee->isa<StructType>() || pointee->isa<TupleType>()) && is_dereferenceable(lea->ptr());
+    }
+
+    return false;
+}
+
+bool is_speculatable(const PrimOp* primop) {
+    if (auto load = primop->isa<Load>())
+        return is_dereferenceable(load->ptr());
+    if (primop->isa<MemOp>() || primop->isa<Hlt>() || primop->isa<Known>() || primop->isa<Run>())
+        return false;
+    if (is_div_or_rem(primop) && is_type_i(primop->type()))
+        return primop->as<ArithOp>()->rhs()->isa<PrimLit>() && !is_zero(primop->as<ArithOp>()->rhs()) && !is_allset(primop->as<ArithOp>()->rhs());
+    if (auto aggop = primop->isa<AggOp>())
+        return aggop->index()->isa<PrimLit>();
+    return true;
+}
+
+const Def* skip_loads(const Def* mem, std::function<bool(const Load*)> skip) {
+    while (auto extract = mem->isa<Extract>()) {
+        auto load = extract->agg()->isa<Load>();
+        if (load == nullptr || !skip(load))
+            break;
+        mem = load->mem();
+    }
+    return mem;
+}
+
+class IfConverter {
+public:
+    IfConverter(const Scope& scope, const IfConversionConfig& config)
+        : scope_(scope)
+        , config_(config)
+    {
+        Scheduler scheduler(scope);
+        for (auto def : scope.defs()) {
+            if (auto primop = def->isa<PrimOp>(); primop && scheduler.is_live(primop))
+                schedule_[scheduler.late(primop)].push_back(primop);
+        }
+    }
+
+    World& world() const { return scope_.world(); }
+    bool run();
+
+private:
+    bool convert(Continuation* head);
+
+    const Scope& scope_;
+    const IfConversionConfig& config_;
+    ContinuationMap<std::vector<const PrimOp*>> schedule_;
+    ContinuationSet touched_;
+};
+
+bool IfConverter::run() {
+    // innermost diamonds first - a converted diamond may turn its surrounding one into a candidate in the next round
+    size_t num = 0;
+    auto rpo = scope_.f_cfg().reverse_post_order();
+    for (size_t i = rpo.size(); i-- != 0;) {
+        if (convert(rpo[i]->continuation()))
+            ++num;
+    }
+
+    if (num != 0)
+        world().ILOG("converted {} branches into selects in {}", num, scope_.entry());
+    return num != 0;
+}
+
+bool IfConverter::convert(Continuation* head) {
+    auto callee = head->callee()->isa_continuation();
+    if (callee == nullptr || callee->intrinsic() != Intrinsic::Branch || touched_.contains(head))
+        return false;
+
+    auto cond = head->arg(0);
+    auto t = head->arg(1)->isa_continuation(), f = head->arg(2)->isa_continuation();
+    if (t == nullptr || f == nullptr || t == f)
+        return false;
+    for (auto arm : {t, f}) {
+        if (arm->empty() || arm->num_uses() != 1 || touched_.contains(arm))
+            return false;
+    }
+
+    auto join = t->callee();
+    if (join != f->callee() || t->num_args() != f->num_args())
+        return false;
+    if (auto continuation = join->isa_continuation()) {
+        auto intrinsic = continuation->intrinsic();
+        if (intrinsic != Intrinsic::None && intrinsic != Intrinsic::Branch && intrinsic != Intrinsic::Match)
+            return false;
+    }
+
+    size_t size = 0;
+    for (auto arm : {t, f}) {
+        if (auto i = schedule_.find(arm); i != schedule_.end()) {
+            for (auto primop : i->second) {
+                if (!is_speculatable(primop))
+                    return false;
+            }
+            size += i->second.size();
+        }
+    }
+    if (size > config_.max_size)
+        return false;
+
+    // the arms only load memory - so both leave it as it was before the branch
+    // loads of the head stay on the chain: a store after the join must not overtake them
+    auto within_arms = [&](const Load* load) {
+        for (auto arm : {t, f}) {
+            if (auto i = schedule_.find(arm); i != schedule_.end() && std::find(i->second.begin(), i->second.end(), load) != i->second.end())
+                return true;
+        }
+        return false;
+    };
+    for (size_t i = 0, e = t->num_args(); i != e; ++i) {
+        auto a = t->arg(i), b = f->arg(i);
+        if (a == b)
+            continue;
+        if (is_mem(a) ? skip_loads(a, within_arms) != skip_loads(b, within_arms) : !a->type()->isa<PrimType>() && !a->type()->isa<PtrType>())
+            return false;
+    }
+
+    Array<const Def*> args(t->num_args());
+    for (size_t i = 0, e = args.size(); i != e; ++i) {
+        auto a = t->arg(i), b = f->arg(i);
+        if (a == b)
+            args[i] = a;
+        else if (is_mem(a))
+            args[i] = skip_loads(a, within_arms);
+        else
+            args[i] = world().select(cond, a, b, a->debug());
+    }
+
+    head->jump(join, args, head->debug());
+    touched_.emplace(head);
+    touched_.emplace(t);
+    touched_.emplace(f);
+    return true;
+}
+
+void if_conversion(World& world, const IfConversionConfig& config) {
+    world.VLOG("start if_conversion");
+
+    // kernels are converted by their backend with the device's config
+    transform_in_rounds(world, [&](const Scope& scope) { return IfConverter(scope, config).run(); },
+                        [] (Continuation* intrinsic) { return intrinsic->is_device_backend(); });
+
+    world.VLOG("end if_conversion");
+    debug_verify(world);
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef THORIN_TRANSFORM_IF_CONVERSION_H
+#define THORIN_TRANSFORM_IF_CONVERSION_H
+
+#include <cstddef>
+#include <functional>
+
+namespace thorin {
+
+class Def;
+class Load;
+class PrimOp;
+class World;
+enum class Target;
+
+/// Tuning knobs of @p if_conversion.
+struct IfConversionConfig {
+    /// Upper bound on the number of @p PrimOp%s of both arms which are executed unconditionally afterwards.
+    size_t max_size;
+
+    static IfConversionConfig get(Target);
+};
+
+/// May @p primop be evaluated although the program would not have done so?
+bool is_speculatable(const PrimOp* primop);
+/// The memory state before the chain of @p Load%s which produces @p mem - the walk stops at the first @p Load for which @p skip does not hold.
+const Def* skip_loads(const Def* mem, std::function<bool(const Load*)> skip);
+
+/**
+ * Converts @c branch diamonds into @p Select%s.
+ * Both arms of such a diamond are only entered from the @c branch and jump to the same join - the @c branch is replaced by a jump to the join whose arguments are selected with the @c branch's condition.
+ * Triangles are diamonds where one arm merely forwards values.
+ * The arms must only compute values that are safe to speculate: this excludes all memory operations except @p Load%s from @p Slot%s or @p Global%s - possibly indexed with constants in bounds - as well as divisions by non-constant values.
+ */
+void if_conversion(World&, const IfConversionConfig& config);
+
+}
+
+#endif
@@ -29,78 +29,111 @@ const Type* Importer::import(const Type* otype) {
 }
 
 const Def* Importer::import(Tracker odef) {
-    if (auto ndef = def_old2new_.lookup(odef)) {
-        assert(&(*ndef)->world() == &world_);
-        assert(!(*ndef)->is_replaced());
-        return *ndef;
+    auto ndef = import_def(odef);
+
+    // bodies are imported in a worklist fashion - this keeps the native stack flat even for long chains of continuations
+    while (!bodies_.empty()) {
+        auto ocontinuation = pop(bodies_);
+        import_body(ocontinuation, def_old2new_[ocontinuation]->as_continuation());
     }
 
-    auto ntype = import(odef->type());
+    assert(&ndef->world() == &world_);
+    assert(!ndef->is_replaced());
+    return ndef;
+}
 
-    if (auto oparam = odef->isa<Param>()) {
-        auto ncont = import(oparam->continuation())->as_continuation();
-        auto nparam = ncont->param(oparam->index());
-        assert(nparam && &nparam->world() == &world_);
-        assert(!nparam->is_replaced());
-        return nparam;
-    }
+const Def* Importer::import_def(const Def* odef) {
+    auto resolve = [](const Def* def) { return Tracker(def).def(); };
 
-    Continuation* ncontinuation = nullptr;
-    if (auto ocontinuation = odef->isa_continuation()) { // create stub in new world
-        // TODO maybe we want to deal with intrinsics in a more streamlined way
-        if (ocontinuation == ocontinuation->world().branch())
-            return def_old2new_[ocontinuation] = world().branch();
-        if (ocontinuation == ocontinuation->world().end_scope())
-            return def_old2new_[ocontinuation] = world().end_scope();
-        auto npi = import(ocontinuation->type())->as<FnType>();
-        ncontinuation = world().continuation(npi, ocontinuation->attributes(), ocontinuation->debug_history());
-        assert(&ncontinuation->world() == &world());
-        assert(&npi->table() == &world());
-        for (size_t i = 0, e = ocontinuation->num_params(); i != e; ++i) {
-            ncontinuation->param(i)->set_name(ocontinuation->param(i)->debug_history().name);
-            def_old2new_[ocontinuation->param(i)] = ncontinuation->param(i);
-        }
+    post_order_walk(resolve(odef),
+        [&](const Def* def) {
+            if (def_old2new_.contains(def)) return false;
+            if (auto oparam = def->isa<Param>()) {
+                auto ncontinuation = import_stub(oparam->continuation())->as_continuation();
+                def_old2new_[oparam] = ncontinuation->param(oparam->index());
+                return false;
+            }
+            if (auto ocontinuation = def->isa_continuation()) {
+                import_stub(ocontinuation);
+                return false;
+            }
+            return true;
+        },
+        [&](const Def* def) {
+            Array<const Def*> ops(def->num_ops());
+            for (size_t i = 0, e = ops.size(); i != e; ++i)
+                ops[i] = resolve(def->op(i));
+            return ops;
+        },
+        [&](const Def* def) {
+            auto oprimop = def->as<PrimOp>();
+            Array<const Def*> nops(oprimop->num_ops());
+            for (size_t i = 0, e = nops.size(); i != e; ++i) {
+                nops[i] = def_old2new_[resolve(oprimop->op(i))];
+                assert(&nops[i]->world() == &world());
+            }
 
-        def_old2new_[ocontinuation] = ncontinuation;
+            auto nprimop = oprimop->rebuild(world(), import(oprimop->type()), nops);
+            todo_ |= oprimop->tag() != nprimop->tag();
+            assert(!nprimop->is_replaced());
+            def_old2new_[oprimop] = nprimop;
+        });
 
-        if (ocontinuation->num_ops() > 0 && ocontinuation->callee() == ocontinuation->world().branch()) {
-            auto cond = import(ocontinuation->arg(0));
-            if (auto lit = cond->isa<PrimLit>()) {
-                auto callee = import(lit->value().get_bool() ? ocontinuation->arg(1) : ocontinuation->arg(2));
-                ncontinuation->jump(callee, {}, ocontinuation->debug()); // TODO debug
+    return def_old2new_[resolve(odef)];
+}
 
-                assert(!ncontinuation->is_replaced());
-                return ncontinuation;
-            }
-        }
+const Def* Importer::import_stub(Continuation* ocontinuation) {
+    if (auto ndef = def_old2new_.lookup(ocontinuation))
+        return *ndef;
+
+    // TODO maybe we want to deal with intrinsics in a more streamlined way
+    if (ocontinuation == ocontinuation->world().branch())
+        return def_old2new_[ocontinuation] = world().branch();
+    if (ocontinuation == ocontinuation->world().end_scope())
+        return def_old2new_[ocontinuation] = world().end_scope();
+
+    auto npi = import(ocontinuation->type())->as<FnType>();
+    auto ncontinuation = world().continuation(npi, ocontinuation->attributes(), ocontinuation->debug_history());
+    assert(&ncontinuation->world() == &world());
+    assert(&npi->table() == &world());
+    for (size_t i = 0, e = ocontinuation->num_params(); i != e; ++i) {
+        ncontinuation->param(i)->set_name(ocontinuation->param(i)->debug_history().name);
+        def_old2new_[ocontinuation->param(i)] = ncontinuation->param(i);
+    }
+
+    bodies_.push(ocontinuation);
+    return def_old2new_[ocontinuation] = ncontinuation;
+}
 
-        auto old_profile = ocontinuation->filter();
-        Array<const Def*> new_profile(old_profile.size());
-        for (size_t i = 0, e = old_profile.size(); i != e; ++i)
-            new_profile[i] = import(old_profile[i]);
-        ncontinuation->set_filter(new_profile);
+void Importer::import_body(Continuation* ocontinuation, Continuation* ncontinuation) {
+    assert(&ncontinuation->world() == &world());
+
+    if (ocontinuation->num_ops() > 0 && ocontinuation->callee() == ocontinuation->world().branch()) {
+        auto cond = import_def(ocontinuation->arg(0));
+        if (auto lit = cond->isa<PrimLit>()) {
+            auto callee = import_def(lit->value().get_bool() ? ocontinuation->arg(1) : ocontinuation->arg(2));
+            ncontinuation->jump(callee, {}, ocontinuation->debug()); // TODO debug
+            assert(!ncontinuation->is_replaced());
+            return;
+        }
     }
 
-    size_t size = odef->num_ops();
+    auto old_profile = ocontinuation->filter();
+    Array<const Def*> new_profile(old_profile.size());
+    for (size_t i = 0, e = old_profile.size(); i != e; ++i)
+        new_profile[i] = import_def(old_profile[i]);
+    ncontinuation->set_filter(new_profile);
+
+    size_t size = ocontinuation->num_ops();
     Array<const Def*> nops(size);
     for (size_t i = 0; i != size; ++i) {
-        nops[i] = import(odef->op(i));
+        nops[i] = import_def(ocontinuation->op(i));
         assert(&nops[i]->world() == &world());
     }
 
-    if (auto oprimop = odef->isa<PrimOp>()) {
-        auto nprimop = oprimop->rebuild(world(), ntype, nops);
-        todo_ |= oprimop->tag() != nprimop->tag();
-        assert(!nprimop->is_replaced());
-        return def_old2new_[oprimop] = nprimop;
-    }
-
-    auto ocontinuation = odef->as_continuation();
-    assert(ncontinuation && &ncontinuation->world() == &world());
     if (size > 0)
         ncontinuation->jump(nops.front(), nops.skip_front(), ocontinuation->debug()); // TODO debug
     assert(!ncontinuation->is_replaced());
-    return ncontinuation;
 }
 
 }
@@ -24,11 +24,20 @@ public:
     const Def* import(Tracker);
     bool todo() const { return todo_; }
 
+private:
+    /// Imports @p odef and all @p PrimOp%s it depends on; @p Continuation%s only get a stub and are queued in @p bodies_.
+    const Def* import_def(const Def* odef);
+    const Def* import_stub(Continuation* ocontinuation);
+    void import_body(Continuation* ocontinuation, Continuation* ncontinuation);
+
 public:
     Type2Type type_old2new_;
     Def2Def def_old2new_;
     World world_;
     bool todo_ = false;
+
+private:
+    std::queue<Continuation*> bodies_;
 };
 
 }
@@ -1,5 +1,6 @@
 #include "thorin/continuation.h"
 #include "thorin/world.h"
+#include "thorin/analyses/callgraph.h"
 #include "thorin/analyses/cfg.h"
 #include "thorin/analyses/scope.h"
 #include "thorin/analyses/verify.h"
@@ -40,6 +41,7 @@ void inliner(World& world) {
     static const int factor = 4;
     static const int offset = 4;
 
+    CallGraph callgraph(world);
     ContinuationMap<std::unique_ptr<Scope>> continuation2scope;
 
     auto get_scope = [&] (Continuation* continuation) -> Scope* {
@@ -54,6 +56,10 @@ void inliner(World& world) {
             auto scope = get_scope(continuation);
             if (scope->defs().size() < scope->entry()->num_params() * factor + offset) {
                 // check that the function is not recursive to prevent inliner from peeling loops
+                if (auto node = callgraph[continuation])
+                    return node->is_recursive() ? nullptr : scope;
+
+                // not a top-level continuation: fall back to checking its uses
                 for (auto& use : continuation->uses()) {
                     // note that if there was an edge from parameter to continuation,
                     // we would need to check if the use is a parameter here.
@@ -66,7 +72,9 @@ void inliner(World& world) {
         return nullptr;
     };
 
-    Scope::for_each(world, [&] (Scope& scope) {
+    // visit callees before their callers so that we inline already optimized callees
+    for (auto node : callgraph.bottom_up()) {
+        auto& scope = *get_scope(node->continuation());
         bool dirty = false;
         for (auto n : scope.f_cfg().post_order()) {
             auto continuation = n->continuation();
@@ -82,13 +90,9 @@ void inliner(World& world) {
             }
         }
 
-        if (dirty) {
+        if (dirty)
             scope.update();
-
-            if (auto s = get_scope(scope.entry()))
-                s->update();
-        }
-    });
+    }
 
     world.VLOG("stop inliner");
     debug_verify(world);
@@ -10,16 +10,69 @@ namespace thorin {
 const Def* Rewriter::instantiate(const Def* odef) {
     if (auto ndef = old2new.lookup(odef)) return *ndef;
 
-    if (auto oprimop = odef->isa<PrimOp>()) {
-        Array<const Def*> nops(oprimop->num_ops());
-        for (size_t i = 0; i != oprimop->num_ops(); ++i)
-            nops[i] = instantiate(odef->op(i));
+    post_order_walk(odef,
+        [&](const Def* def) {
+            if (old2new.contains(def)) return false;
+            if (def->isa<PrimOp>()) return true;
+            old2new[def] = def;
+            return false;
+        },
+        [&](const Def* def) { return def->ops(); },
+        [&](const Def* def) {
+            auto oprimop = def->as<PrimOp>();
+            Array<const Def*> nops(oprimop->num_ops());
+            for (size_t i = 0; i != oprimop->num_ops(); ++i)
+                nops[i] = old2new[oprimop->op(i)];
+
+            old2new[oprimop] = oprimop->rebuild(oprimop->world(), oprimop->type(), nops);
+        });
+
+    return old2new[odef];
+}
+
+const Def* instantiate(Def2Def& old2new, const Def* odef) {
+    if (auto ndef = old2new.lookup(odef)) return *ndef;
+
+    post_order_walk(odef,
+        [&](const Def* def) {
+            if (old2new.contains(def)) return false;
+            if (def->isa<PrimOp>()) return true;
+            old2new[def] = def;
+            return false;
+        },
+        [&](const Def* def) { return def->ops(); },
+        [&](const Def* def) {
+            auto oprimop = def->as<PrimOp>();
+            Array<const Def*> nops(oprimop->num_ops());
+            bool changed = false;
+            for (size_t i = 0, e = oprimop->num_ops(); i != e; ++i) {
+                nops[i] = old2new[oprimop->op(i)];
+                changed |= nops[i] != oprimop->op(i);
+            }
+
+            old2new[oprimop] = changed ? oprimop->rebuild(oprimop->world(), oprimop->type(), nops) : oprimop;
+        });
+
+    return old2new[odef];
+}
+
+void clone_body(Def2Def& old2new, Continuation* ocontinuation, Continuation* ncontinuation) {
+    Array<const Def*> nargs(ocontinuation->num_args());
+    for (size_t i = 0, e = nargs.size(); i != e; ++i)
+        nargs[i] = instantiate(old2new, ocontinuation->arg(i));
+    ncontinuation->jump(instantiate(old2new, ocontinuation->callee()), nargs, ocontinuation->debug());
+}
 
-        auto nprimop = oprimop->rebuild(oprimop->world(), oprimop->type(), nops);
-        return old2new[oprimop] = nprimop;
+void clone(Def2Def& old2new, ArrayRef<Continuation*> continuations) {
+    for (auto ocontinuation : continuations) {
+        auto ncontinuation = ocontinuation->stub();
+        old2new[ocontinuation] = ncontinuation;
+        for (size_t i = 0, e = ocontinuation->num_params(); i != e; ++i)
+            old2new[ocontinuation->param(i)] = ncontinuation->param(i);
     }
 
-    return old2new[odef] = odef;
+    for (auto ocontinuation : continuations)
+        clone_body(old2new, ocontinuation, old2new[ocontinuation]->as_continuation());
 }
 
 Mangler::Mangler(const Scope& scope, Defs args, Defs lift)
@@ -54,6 +54,13 @@ inline Continuation* clone(const Scope& scope) {
     return mangle(scope, Array<const Def*>(scope.entry()->num_params()), Defs());
 }
 
+/// Like @p Rewriter::instantiate but only rebuilds @p PrimOp%s whose operands change - this keeps e.g. @p Global%s intact.
+const Def* instantiate(Def2Def& old2new, const Def* odef);
+/// Lets @p ncontinuation jump like @p ocontinuation with all operands instantiated according to @p old2new.
+void clone_body(Def2Def& old2new, Continuation* ocontinuation, Continuation* ncontinuation);
+/// Clones @p continuations; references to other @p Continuation%s and their @p Param%s are substituted according to @p old2new.
+void clone(Def2Def& old2new, ArrayRef<Continuation*> continuations);
+
 }
 
 #endif
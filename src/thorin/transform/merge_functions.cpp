@@ -0,0 +1,75 @@
+#include "thorin/transform/merge_functions.h"
+
+#include <unordered_map>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/scope_hash.h"
+
+namespace thorin {
+
+/// Redirects all uses of @p continuation to @p rep; @p PrimOp%s are rebuilt to keep hash-consing intact.
+static void redirect(World& world, Continuation* continuation, Continuation* rep) {
+    for (auto use : continuation->copy_uses()) {
+        if (auto ucontinuation = use->isa_continuation()) {
+            ucontinuation->update_op(use.index(), rep);
+        } else {
+            auto primop = use->as<PrimOp>();
+            Array<const Def*> nops(primop->ops());
+            nops[use.index()] = rep;
+            primop->replace(primop->rebuild(world, primop->type(), nops));
+        }
+    }
+}
+
+/// One round of merging; returns the number of removed duplicates.
+static size_t merge(World& world) {
+    std::vector<Continuation*> entries;
+    Scope::for_each(world, [&](const Scope& scope) { entries.push_back(scope.entry()); });
+    // prefer external functions as representatives and be deterministic otherwise
+    std::sort(entries.begin(), entries.end(), [](Continuation* a, Continuation* b) {
+        return a->is_external() != b->is_external() ? a->is_external() : a->gid() < b->gid();
+    });
+
+    std::unordered_map<hash_t, std::vector<std::unique_ptr<Scope>>> hash2scopes;
+    size_t num = 0;
+    for (auto entry : entries) {
+        if (entry->empty() || entry->is_intrinsic() || is_passed_to_accelerator(entry))
+            continue;
+
+        auto scope = std::make_unique<Scope>(entry);
+        auto& scopes = hash2scopes[hash_combine(structural_hash(*scope), uint32_t(entry->type()->gid()))];
+        auto i = std::find_if(scopes.begin(), scopes.end(), [&](const std::unique_ptr<Scope>& other) {
+            return structurally_equal(*other, *scope);
+        });
+
+        if (i == scopes.end() || entry->is_external()) {
+            scopes.push_back(std::move(scope));
+            continue;
+        }
+
+        auto rep = (*i)->entry();
+        world.DLOG("merge {} into {}", entry, rep);
+        redirect(world, entry, rep);
+        ++num;
+    }
+
+    return num;
+}
+
+void merge_functions(World& world) {
+    world.VLOG("start merge_functions");
+
+    // merging callees may render their callers equal - iterate
+    size_t total = 0;
+    while (size_t num = merge(world)) {
+        total += num;
+        world.cleanup();
+    }
+
+    world.VLOG("merged {} functions", total);
+    world.VLOG("end merge_functions");
+}
+
+}
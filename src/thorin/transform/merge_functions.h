@@ -0,0 +1,17 @@
+#ifndef THORIN_TRANSFORM_MERGE_FUNCTIONS_H
+#define THORIN_TRANSFORM_MERGE_FUNCTIONS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Merges top-level functions which are structurally equal - see @p structurally_equal.
+ * All uses of a duplicate are redirected to a single representative.
+ * Bodies passed to an accelerator are left to @p dedup_kernels.
+ */
+void merge_functions(World&);
+
+}
+
+#endif
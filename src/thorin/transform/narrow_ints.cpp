@@ -0,0 +1,157 @@
+#include "thorin/transform/narrow_ints.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/value_range.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// The 32-bit counterpart of the 64-bit integer @p type or @c nullptr.
+static const PrimType* narrow_type(World& world, const Type* type) {
+    auto prim_type = type->isa<PrimType>();
+    if (prim_type == nullptr || prim_type->length() != 1)
+        return nullptr;
+    switch (prim_type->primtype_tag()) {
+        case PrimType_ps64: return world.type_ps32();
+        case PrimType_qs64: return world.type_qs32();
+        case PrimType_pu64: return world.type_pu32();
+        case PrimType_qu64: return world.type_qu32();
+        default:            return nullptr;
+    }
+}
+
+/// Does @p range fit into the 32-bit counterpart of @p type? @p LEA indices are always interpreted as signed.
+static bool fits(Interval range, const Type* type, bool index = false) {
+    if (is_type_s(type) || index)
+        return range.within(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
+    return range.within(0, std::numeric_limits<uint32_t>::max());
+}
+
+class NarrowInts {
+public:
+    NarrowInts(const Scope& scope)
+        : scope_(scope)
+        , ranges_(scope)
+        , scheduler_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    bool run();
+
+private:
+    const Def* narrow(const Def*);
+
+    const Scope& scope_;
+    ValueRanges ranges_;
+    Scheduler scheduler_;
+    DefMap<const Def*> narrowed_;
+    size_t num_arithops_ = 0, num_cmps_ = 0, num_leas_ = 0;
+};
+
+/// Returns the 32-bit version of @p def.
+const Def* NarrowInts::narrow(const Def* def) {
+    if (auto i = narrowed_.find(def); i != narrowed_.end())
+        return i->second;
+
+    auto type = narrow_type(world(), def->type());
+    if (auto cast = def->isa<Cast>(); cast && cast->from()->type() == type)
+        return cast->from();
+    return world().cast(type, def, def->debug());
+}
+
+bool NarrowInts::run() {
+    std::vector<const PrimOp*> candidates;
+    for (auto def : scope_.defs()) {
+        if (!scheduler_.is_live(def))
+            continue;
+        if (auto arithop = def->isa<ArithOp>(); arithop && narrow_type(world(), arithop->type()))
+            candidates.push_back(arithop);
+        else if (auto cmp = def->isa<Cmp>(); cmp && narrow_type(world(), cmp->lhs()->type()))
+            candidates.push_back(cmp);
+        else if (auto lea = def->isa<LEA>(); lea && narrow_type(world(), lea->index()->type()) && lea->ptr_pointee()->isa<ArrayType>())
+            candidates.push_back(lea);
+    }
+    // ops first
+    std::sort(candidates.begin(), candidates.end(), [](const PrimOp* a, const PrimOp* b) { return a->gid() < b->gid(); });
+
+    // decide first as rewriting changes the graph
+    std::vector<const PrimOp*> todo;
+    DefSet done;
+    // only narrow if no new truncation is needed - otherwise, we merely trade a 64-bit op for a conversion
+    auto is_cheap = [&](const Def* def) {
+        if (def->isa<PrimLit>() || done.contains(def))
+            return true;
+        auto cast = def->isa<Cast>();
+        return cast && is_type_i(cast->from()->type()) && num_bits(cast->from()->type()->as<PrimType>()->primtype_tag()) <= 32;
+    };
+
+    for (auto primop : candidates) {
+        // the value is only used where late(primop) dominates - so the branch conditions dominating it hold
+        auto context = scheduler_.late(primop);
+        if (context == nullptr)
+            continue;
+
+        bool ok = true;
+        if (auto lea = primop->isa<LEA>()) {
+            ok = is_cheap(lea->index()) && fits(ranges_.range(lea->index(), context), lea->index()->type(), true);
+        } else {
+            for (auto op : primop->ops())
+                ok &= is_cheap(op) && fits(ranges_.range(op, context), op->type());
+            if (auto arithop = primop->isa<ArithOp>()) {
+                ok &= fits(ranges_.range(primop, context), primop->type());
+                // the result of x >> 40 may fit but shifting a 32-bit value by 40 is undefined
+                if (arithop->arithop_tag() == ArithOp_shl || arithop->arithop_tag() == ArithOp_shr)
+                    ok &= ranges_.range(arithop->rhs(), context).within(0, 31);
+            }
+        }
+
+        if (ok) {
+            world().DLOG("narrow {} in {}", primop, scope_.entry());
+            todo.push_back(primop);
+            done.emplace(primop);
+        }
+    }
+
+    for (auto primop : todo) {
+        auto dbg = primop->debug();
+        if (auto arithop = primop->isa<ArithOp>()) {
+            auto narrowed = world().arithop(arithop->arithop_tag(), narrow(arithop->lhs()), narrow(arithop->rhs()), dbg);
+            narrowed_[arithop] = narrowed;
+            arithop->replace(world().cast(arithop->type(), narrowed, dbg));
+            ++num_arithops_;
+        } else if (auto cmp = primop->isa<Cmp>()) {
+            cmp->replace(world().cmp(cmp->cmp_tag(), narrow(cmp->lhs()), narrow(cmp->rhs()), dbg));
+            ++num_cmps_;
+        } else if (auto lea = primop->isa<LEA>()) {
+            lea->replace(world().lea(lea->ptr(), narrow(lea->index()), dbg));
+            ++num_leas_;
+        }
+    }
+
+    if (todo.empty())
+        return false;
+
+    world().ILOG("narrowed {} arithmetic ops, {} comparisons and {} address computations to 32 bits in {}",
+                 num_arithops_, num_cmps_, num_leas_, scope_.entry());
+    return true;
+}
+
+void narrow_ints(World& world) {
+    world.VLOG("start narrow_ints");
+
+    bool todo = false;
+    Scope::for_each(world, [&](const Scope& scope) {
+        NarrowInts narrow_ints(scope);
+        todo |= narrow_ints.run();
+    });
+
+    world.VLOG("end narrow_ints");
+    debug_verify(world);
+    if (todo)
+        world.cleanup();
+}
+
+}
@@ -0,0 +1,17 @@
+#ifndef THORIN_TRANSFORM_NARROW_INTS_H
+#define THORIN_TRANSFORM_NARROW_INTS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Narrows 64-bit @p ArithOp%s, @p Cmp%s and @p LEA indices to 32 bits whenever @p ValueRanges proves that all involved values fit.
+ * This is meant for the worlds of GPU backends where 64-bit integer arithmetic doubles register use and instruction count.
+ * Logs a report of what was narrowed per function.
+ */
+void narrow_ints(World&);
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+#include "thorin/transform/parallelize.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/induction.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+#include "thorin/transform/mangle.h"
+#include "thorin/util/utility.h"
+
+namespace thorin {
+
+ParallelConfig ParallelConfig::get(Target target) {
+    switch (target) {
+        // forking and joining threads costs a few microseconds
+        case Target::CPU: return {1024, 0};
+        // the parallel intrinsic only exists on the CPU
+        case Target::GPU: return {0, 0};
+        case Target::HLS: return {0, 0};
+    }
+    THORIN_UNREACHABLE;
+}
+
+class Parallelizer {
+public:
+    using Loop = InductionVars::Loop;
+
+    Parallelizer(const Scope& scope, const ParallelConfig& config)
+        : scope_(scope)
+        , config_(config)
+        , ivs_(scope)
+        , mssa_(scope)
+    {
+        Scheduler scheduler(scope);
+        for (auto def : scope.defs()) {
+            if (auto memop = def->isa<MemOp>(); memop != nullptr && scheduler.is_live(memop))
+                memops_[scheduler.smart(memop)].push_back(memop);
+        }
+    }
+
+    World& world() const { return scope_.world(); }
+    bool run();
+
+private:
+    /// The @p Continuation%s of @p loop - header first.
+    std::vector<Continuation*> region(const Loop&) const;
+    const InductionVar* counter(const Loop&, const Def*& bound);
+    bool is_independent(const Loop&, const InductionVar* counter, ArrayRef<Continuation*> region);
+    bool same_element(const Loop&, const InductionVar* counter, const Def* a, const Def* b);
+    std::optional<Affine> index(const Loop&, const InductionVar* counter, const PtrInfo& info);
+    bool parallelize(const Loop&);
+
+    const Scope& scope_;
+    const ParallelConfig& config_;
+    InductionVars ivs_;
+    MemorySSA mssa_;
+    ContinuationMap<std::vector<const MemOp*>> memops_;
+};
+
+/// Performs at most one transformation with outer loops first - see @p transform_in_rounds.
+bool Parallelizer::run() {
+    const auto& loops = ivs_.loops();
+    for (auto i = loops.rbegin(), e = loops.rend(); i != e; ++i) {
+        if (parallelize(*i))
+            return true;
+    }
+    return false;
+}
+
+std::vector<Continuation*> Parallelizer::region(const Loop& loop) const {
+    std::vector<Continuation*> result;
+    for (auto n : ivs_.cfg().reverse_post_order()) {
+        if (ivs_.contains(loop, n->continuation()))
+            result.push_back(n->continuation());
+    }
+    assert(result.front() == loop.header);
+    return result;
+}
+
+/// The counter of @p loop tested via <tt>counter < bound</tt> at the header - @c nullptr if there is none.
+const InductionVar* Parallelizer::counter(const Loop& loop, const Def*& bound) {
+    if (!loop.exits_at_header)
+        return nullptr;
+    auto cmp = loop.header->arg(0)->isa<Cmp>();
+    if (cmp == nullptr)
+        return nullptr;
+
+    auto tag = loop.body == loop.header->arg(1) ? cmp->cmp_tag() : negate(cmp->cmp_tag());
+    auto lhs = cmp->lhs(), rhs = cmp->rhs();
+    if (tag == Cmp_gt) {
+        std::swap(lhs, rhs);
+        tag = Cmp_lt;
+    }
+    auto param = lhs->isa<Param>();
+    auto iv = param != nullptr ? ivs_.iv(param) : nullptr;
+    if (tag != Cmp_lt || iv == nullptr || iv->param->continuation() != loop.header || !ivs_.is_invariant(loop, rhs))
+        return nullptr;
+
+    auto step = iv->step->isa<PrimLit>();
+    auto tag32 = iv->param->type()->tag();
+    if (step == nullptr || primlit_value<int64_t>(step) != 1 || (tag32 != Node_PrimType_qs32 && tag32 != Node_PrimType_ps32))
+        return nullptr;
+
+    bound = rhs;
+    return iv;
+}
+
+/// The @p Affine index of the element @p info refers to - all other indices along its path must be constants.
+std::optional<Affine> Parallelizer::index(const Loop& loop, const InductionVar* counter, const PtrInfo& info) {
+    if (!info.exact || !ivs_.is_invariant(loop, info.base))
+        return std::nullopt;
+
+    std::optional<Affine> result;
+    for (auto index : info.path) {
+        if (index->isa<PrimLit>())
+            continue;
+        if (result)
+            return std::nullopt;
+        result = ivs_.affine(loop, index);
+        if (!result || result->iv != counter)
+            return std::nullopt;
+    }
+    return result;
+}
+
+/// Do the pointers @p a and @p b refer to the same element in each iteration?
+bool Parallelizer::same_element(const Loop& loop, const InductionVar* counter, const Def* a, const Def* b) {
+    auto ia = mssa_.ptr_info(a); // copy - the lookup of b may rehash
+    const auto& ib = mssa_.ptr_info(b);
+    if (ia.base != ib.base || ia.path.size() != ib.path.size())
+        return false;
+    for (size_t i = 0, e = ia.path.size(); i != e; ++i) {
+        if (ia.path[i]->isa<PrimLit>() != ib.path[i]->isa<PrimLit>() || (ia.path[i]->isa<PrimLit>() && ia.path[i] != ib.path[i]))
+            return false;
+    }
+
+    auto xa = index(loop, counter, ia), xb = index(loop, counter, ib);
+    return xa && xb && xa->scale == xb->scale && xa->offset == xb->offset;
+}
+
+bool Parallelizer::is_independent(const Loop& loop, const InductionVar* counter, ArrayRef<Continuation*> region) {
+    std::vector<const Access*> accesses;
+    std::vector<const Store*> stores;
+    for (auto continuation : region) {
+        if (auto i = memops_.find(continuation); i != memops_.end()) {
+            for (auto memop : i->second) {
+                // the header is evaluated once more after the parallel loop
+                if (continuation == loop.header)
+                    return false;
+                if (auto store = memop->isa<Store>())
+                    stores.push_back(store);
+                if (auto access = memop->isa<Access>())
+                    accesses.push_back(access);
+                else if (!memop->isa<Enter>())
+                    return false;
+            }
+        }
+    }
+
+    for (auto store : stores) {
+        // slots allocated within the loop are private to each iteration
+        const auto& info = mssa_.ptr_info(store->ptr());
+        if (info.base->isa<Slot>() && !ivs_.is_invariant(loop, info.base))
+            continue;
+
+        // distinct iterations must write distinct elements
+        auto store_index = index(loop, counter, info);
+        auto scale = store_index ? store_index->scale->isa<PrimLit>() : nullptr;
+        if (scale == nullptr || primlit_value<int64_t>(scale) == 0)
+            return false;
+
+        for (auto access : accesses) {
+            if (access != store && mssa_.alias(store->ptr(), access->ptr()) != AliasResult::No
+                    && !same_element(loop, counter, store->ptr(), access->ptr()))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Parallelizer::parallelize(const Loop& loop) {
+    auto header = loop.header;
+    if (loop.preheaders.size() != 1 || loop.preheaders.front()->callee() != header || header->num_params() != 2)
+        return false;
+    if (loop.trip_count && *loop.trip_count < config_.min_trip_count)
+        return false;
+
+    const Def* bound = nullptr;
+    auto counter = this->counter(loop, bound);
+    if (counter == nullptr)
+        return false;
+    auto ci = counter->param->index(), mi = 1 - ci;
+    if (!is_mem(header->param(mi)))
+        return false;
+
+    // the loop must stay within itself
+    auto region = this->region(loop);
+    for (auto continuation : ArrayRef<Continuation*>(region).skip_front()) {
+        auto callee = continuation->callee()->isa_continuation();
+        if (callee == nullptr || (callee->intrinsic() != Intrinsic::Branch && !ivs_.contains(loop, callee)))
+            return false;
+    }
+    if (!is_independent(loop, counter, region))
+        return false;
+
+    // body(mem, counter, return): one iteration - the latches return instead of jumping back to the header
+    auto counter_type = counter->param->type();
+    auto return_type = world().fn_type({world().mem_type()});
+    auto body_type = world().fn_type({world().mem_type(), counter_type, return_type});
+    auto body = world().continuation(body_type, header->debug_history());
+    Def2Def old2new;
+    old2new[header->param(mi)] = body->param(0);
+    old2new[header->param(ci)] = body->param(1);
+    clone(old2new, ArrayRef<Continuation*>(region).skip_front());
+    body->jump(old2new[loop.body], {}, header->debug());
+    for (auto latch : loop.latches) {
+        auto copy = old2new[latch]->as_continuation();
+        copy->jump(body->param(2), {copy->arg(mi)}, latch->debug());
+    }
+
+    // after the parallel loop, the header is entered once more with the counter at the bound and takes the exit
+    auto preheader = loop.preheaders.front();
+    auto lower = preheader->arg(ci);
+    auto resume = world().continuation(return_type, header->debug_history());
+    Array<const Def*> args(2);
+    args[mi] = resume->param(0);
+    args[ci] = bound;
+    resume->jump(header, args, header->debug());
+
+    auto parallel_type = world().fn_type({world().mem_type(), world().type_qs32(), counter_type, counter_type, body_type, return_type});
+    auto parallel = world().continuation(parallel_type, Intrinsic::Parallel, {"parallel"});
+    auto dispatch = world().continuation(header->debug_history());
+    dispatch->jump(parallel, {preheader->arg(mi), world().literal_qs32(config_.num_threads, {}), lower, bound, body, resume}, header->debug());
+
+    if (loop.trip_count) {
+        preheader->jump(dispatch, {}, preheader->debug());
+    } else {
+        auto sequential = world().continuation(header->debug_history());
+        sequential->jump(header, preheader->args(), preheader->debug());
+        auto min = world().literal(counter_type->as<PrimType>()->primtype_tag(), Box(int32_t(std::min<uint64_t>(config_.min_trip_count, INT32_MAX))), {});
+        auto cond = world().cmp_ge(world().arithop_sub(bound, lower), min);
+        preheader->branch(cond, dispatch, sequential, preheader->debug());
+    }
+
+    world().ILOG("parallelized loop {}", header);
+    return true;
+}
+
+bool parallelize(World& world, const ParallelConfig& config) {
+    world.VLOG("start parallelize");
+
+    bool result = false;
+    if (config.min_trip_count != 0)
+        result = transform_in_rounds(world, [&](const Scope& scope) { return Parallelizer(scope, config).run(); });
+
+    world.VLOG("end parallelize");
+    debug_verify(world);
+    return result;
+}
+
+}
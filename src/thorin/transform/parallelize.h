@@ -0,0 +1,39 @@
+#ifndef THORIN_TRANSFORM_PARALLELIZE_H
+#define THORIN_TRANSFORM_PARALLELIZE_H
+
+#include <cstdint>
+
+namespace thorin {
+
+class World;
+enum class Target;
+
+/// Tuning knobs of @p parallelize.
+struct ParallelConfig {
+    /// Loops running fewer iterations stay sequential - checked at run time unless the trip count is known; 0 disables the pass.
+    uint64_t min_trip_count;
+    /// Number of threads requested from the runtime; 0 lets the runtime choose.
+    int32_t num_threads;
+
+    static ParallelConfig get(Target);
+};
+
+/**
+ * Turns loops found by @p InductionVars whose iterations are independent into calls of the @c parallel intrinsic.
+ * A loop qualifies if
+ *  - it has a single preheader and only exits at its header via <tt>counter < bound</tt> with a loop-invariant @c bound,
+ *  - its header only receives the @c mem and the counter, a 32-bit signed @p InductionVar with step 1,
+ *  - it calls nothing but its own @p Continuation%s, and
+ *  - each @p Store writes an element that is an @p Affine function of the counter with a constant non-zero scale -
+ *    every other access to memory the @p Store may alias must refer to the very same element in the same iteration.
+ *    Stores to @p Slot%s allocated within the loop are private to each iteration.
+ * All @p Continuation%s of the loop but its header are outlined into the body of the @c parallel call.
+ * The preheader enters the original loop instead if the loop runs fewer than @p ParallelConfig::min_trip_count iterations.
+ * Loops within code that already runs on an accelerator or in parallel are left alone.
+ * Returns whether a loop was parallelized - then, the new bodies still have to be lifted by @p lift_builtins.
+ */
+bool parallelize(World&, const ParallelConfig& config);
+
+}
+
+#endif
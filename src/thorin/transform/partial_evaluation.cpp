@@ -1,5 +1,6 @@
 #include "thorin/primop.h"
 #include "thorin/world.h"
+#include "thorin/analyses/callgraph.h"
 #include "thorin/transform/mangle.h"
 #include "thorin/util/hash.h"
 
@@ -42,25 +43,11 @@ public:
         assert(callee->num_params() == args.size());
 
         for (size_t i = 0, e = args.size(); i != e; ++i)
-            old2new_[callee->param(i)] = args[i];
+            rewriter_.old2new[callee->param(i)] = args[i];
     }
 
     World& world() { return callee_->world(); }
-    const Def* instantiate(const Def* odef) {
-        if (auto ndef = old2new_.lookup(odef))
-            return *ndef;
-
-        if (auto oprimop = odef->isa<PrimOp>()) {
-            Array<const Def*> nops(oprimop->num_ops());
-            for (size_t i = 0; i != oprimop->num_ops(); ++i)
-                nops[i] = instantiate(odef->op(i));
-
-            auto nprimop = oprimop->rebuild(world(), oprimop->type(), nops);
-            return old2new_[oprimop] = nprimop;
-        }
-
-        return old2new_[odef] = odef;
-    }
+    const Def* instantiate(const Def* odef) { return rewriter_.instantiate(odef); }
 
     bool eval(size_t i, bool lower2cff) {
         // the only higher order parameter that is allowed is a single 1st-order fn-parameter of a top-level continuation
@@ -118,7 +105,7 @@ public:
 private:
     Continuation* callee_;
     Defs args_;
-    Def2Def old2new_;
+    Rewriter rewriter_;
     ContinuationMap<bool>& top_level_;
 };
 
@@ -141,10 +128,13 @@ void PartialEvaluator::eat_pe_info(Continuation* cur) {
 bool PartialEvaluator::run() {
     bool todo = false;
 
-    for (auto continuation : world().exported_continuations()) {
-        enqueue(continuation);
+    for (auto continuation : world().exported_continuations())
         top_level_[continuation] = true;
-    }
+
+    // seed the queue bottom-up such that callees are specialized before their callers
+    CallGraph callgraph(world());
+    for (auto node : callgraph.bottom_up())
+        enqueue(node->continuation());
 
     while (!queue_.empty()) {
         auto continuation = pop(queue_);
@@ -0,0 +1,111 @@
+#include "thorin/transform/promote_allocs.h"
+
+#include <algorithm>
+#include <optional>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/escape.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// Allocations of more than this many bytes stay on the heap - @p hoist_enters may put them into the entry frame of a function.
+static const u64 max_stack_bytes = 4096;
+
+/// An upper bound of the number of bytes a value of @p type occupies including padding - @c std::nullopt if unknown.
+static std::optional<u64> num_bytes(const Type* type) {
+    if (auto prim_type = type->isa<PrimType>())
+        return u64(std::max(1, num_bits(prim_type->primtype_tag()) / 8)) * prim_type->length();
+    if (auto ptr_type = type->isa<PtrType>())
+        return 8 * ptr_type->length();
+    if (type->isa<ClosureType>())
+        return 16;
+    if (type->isa<FnType>())
+        return 8;
+
+    if (auto array_type = type->isa<DefiniteArrayType>()) {
+        auto elem = num_bytes(array_type->elem_type());
+        if (!elem || (*elem != 0 && array_type->dim() > max_stack_bytes / *elem))
+            return std::nullopt;
+        return *elem * array_type->dim();
+    }
+
+    if (type->isa<StructType>() || type->isa<TupleType>() || type->isa<VariantType>()) {
+        // each field is padded to at most 8 bytes; a variant holds one of its alternatives and the tag
+        u64 result = 0;
+        for (auto op : type->ops()) {
+            auto field = num_bytes(op);
+            if (!field)
+                return std::nullopt;
+            auto padded = (*field + 7) / 8 * 8;
+            result = type->isa<VariantType>() ? std::max(result, padded) : result + padded;
+        }
+        return type->isa<VariantType>() ? result + 8 : result;
+    }
+    return std::nullopt;
+}
+
+/// Returns the type of the @p Slot replacing @p alloc or @c nullptr, if @p alloc has to stay on the heap.
+static const Type* slot_type(const Alloc* alloc) {
+    auto type = alloc->alloced_type();
+    if (auto array_type = type->isa<IndefiniteArrayType>()) {
+        if (!alloc->extra()->isa<PrimLit>())
+            return nullptr;
+        type = alloc->world().definite_array_type(array_type->elem_type(), primlit_value<u64>(alloc->extra()));
+    }
+    auto bytes = num_bytes(type);
+    return bytes && *bytes <= max_stack_bytes ? type : nullptr;
+}
+
+static void promote(const Alloc* alloc, const Type* type) {
+    auto& world = alloc->world();
+    world.DLOG("promote {} to stack", alloc);
+
+    auto enter = world.enter(alloc->mem(), alloc->debug());
+    auto mem   = world.extract(enter, 0_u32, alloc->debug());
+    auto ptr   = world.slot(type, world.extract(enter, 1, alloc->debug()), alloc->debug());
+    // definite -> indefinite array or address space
+    if (ptr->type() != alloc->out_ptr_type())
+        ptr = world.bitcast(alloc->out_ptr_type(), ptr, alloc->debug());
+
+    for (auto use : alloc->copy_uses()) {
+        if (Alloc::is_out_mem(use.def()))
+            use->replace(mem);
+        else if (Alloc::is_out_ptr(use.def()))
+            use->replace(ptr);
+    }
+}
+
+void promote_allocs(World& world) {
+    world.VLOG("start promote_allocs");
+
+    std::vector<std::pair<const Alloc*, const Type*>> allocs;
+    Scope::for_each(world, [&](const Scope& scope) {
+        for (auto def : scope.defs()) {
+            auto alloc = def->isa<Alloc>();
+            if (alloc == nullptr)
+                continue;
+
+            if (auto type = slot_type(alloc)) {
+                bool escaping = false;
+                for (auto use : alloc->uses()) {
+                    if (Alloc::is_out_ptr(use.def()) && escapes(use.def()))
+                        escaping = true;
+                }
+                if (!escaping)
+                    allocs.emplace_back(alloc, type);
+            }
+        }
+    });
+
+    for (auto [alloc, type] : allocs)
+        promote(alloc, type);
+
+    world.VLOG("end promote_allocs");
+    debug_verify(world);
+    world.cleanup();
+}
+
+}
@@ -0,0 +1,16 @@
+#ifndef THORIN_TRANSFORM_PROMOTE_ALLOCS_H
+#define THORIN_TRANSFORM_PROMOTE_ALLOCS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Replaces @p Alloc%s whose memory does not escape (see @p escapes) by an @p Enter and a @p Slot in the current frame.
+ * Only allocations of a small constant size are promoted - this includes indefinite arrays with a constant number of elements.
+ */
+void promote_allocs(World&);
+
+}
+
+#endif
@@ -0,0 +1,235 @@
+#include "thorin/transform/reorder_fields.h"
+
+#include <algorithm>
+#include <optional>
+#include <queue>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// Size and alignment in bytes as the backends lay out a @p Type.
+struct Layout {
+    uint64_t size;
+    uint64_t align;
+};
+
+static uint64_t align_to(uint64_t offset, uint64_t align) { return (offset + align - 1) / align * align; }
+
+/// Lays out @p fields one after another as in C.
+static Layout layout(ArrayRef<Layout> fields) {
+    uint64_t offset = 0, align = 1;
+    for (auto& field : fields) {
+        offset = align_to(offset, field.align) + field.size;
+        align = std::max(align, field.align);
+    }
+    return {align_to(offset, align), align};
+}
+
+class FieldReorderer {
+public:
+    FieldReorderer(World& world)
+        : world_(world)
+    {}
+
+    World& world() const { return world_; }
+    void run();
+
+private:
+    void pin(const Type* type);
+    const StructType* struct_index(const PrimOp* primop) const;
+    std::optional<Layout> layout(const Type* type);
+    std::optional<Layout> reorder(const StructType* struct_type);
+    void remap(const PrimOp* primop);
+
+    World& world_;
+    TypeSet pinned_;
+    TypeMap<std::optional<Layout>> layouts_;
+    TypeMap<std::vector<size_t>> accesses_;
+    TypeMap<Array<size_t>> old2new_;
+};
+
+void FieldReorderer::run() {
+    // the layout of types that leave the world or are reinterpreted must stay as is
+    for (auto continuation : world().continuations()) {
+        if (continuation->is_external())
+            pin(continuation->type());
+    }
+    for (auto primop : world().primops()) {
+        if (auto bitcast = primop->isa<Bitcast>()) {
+            pin(bitcast->type());
+            pin(bitcast->from()->type());
+        } else if (auto struct_type = struct_index(primop)) {
+            auto& accesses = accesses_[struct_type];
+            accesses.resize(struct_type->num_ops());
+            ++accesses[primlit_value<size_t>(primop->op(1))];
+        }
+    }
+
+    std::vector<const StructType*> struct_types;
+    for (auto type : world().types()) {
+        if (auto struct_type = type->isa<StructType>())
+            struct_types.push_back(struct_type);
+    }
+    std::sort(struct_types.begin(), struct_types.end(), [](auto a, auto b) { return a->gid() < b->gid(); });
+    for (auto struct_type : struct_types)
+        layout(struct_type);
+
+    if (old2new_.empty())
+        return;
+
+    // remapping creates new literals - so iterate over a copy
+    std::vector<const PrimOp*> primops(world().primops().begin(), world().primops().end());
+    for (auto primop : primops)
+        remap(primop);
+
+    for (auto struct_type : struct_types) {
+        if (auto old2new = old2new_.lookup(struct_type)) {
+            Array<const Type*> ops(struct_type->ops());
+            Array<Symbol> names(struct_type->op_names());
+            for (size_t i = 0, e = ops.size(); i != e; ++i) {
+                struct_type->set((*old2new)[i], ops[i]);
+                struct_type->set_op_name((*old2new)[i], names[i]);
+            }
+        }
+    }
+}
+
+/// Marks all types @p type consists of as pinned - pointees included.
+void FieldReorderer::pin(const Type* type) {
+    std::queue<const Type*> queue;
+    auto enqueue = [&](const Type* type) {
+        if (pinned_.emplace(type).second)
+            queue.push(type);
+    };
+
+    enqueue(type);
+    while (!queue.empty()) {
+        for (auto op : pop(queue)->ops())
+            enqueue(op);
+    }
+}
+
+/// The @p StructType @p primop indexes with a constant - if it is an @p Extract, @p Insert or @p LEA into one.
+const StructType* FieldReorderer::struct_index(const PrimOp* primop) const {
+    const Type* type = nullptr;
+    if (auto aggop = primop->isa<AggOp>())
+        type = aggop->agg()->type();
+    else if (auto lea = primop->isa<LEA>())
+        type = lea->ptr_pointee();
+    else
+        return nullptr;
+
+    auto struct_type = type->isa<StructType>();
+    return struct_type != nullptr && primop->op(1)->isa<PrimLit>() ? struct_type : nullptr;
+}
+
+std::optional<Layout> FieldReorderer::layout(const Type* type) {
+    if (auto i = layouts_.find(type); i != layouts_.end())
+        return i->second;
+
+    std::optional<Layout> result;
+    if (auto prim_type = type->isa<PrimType>()) {
+        uint64_t size = std::max(1, num_bits(prim_type->primtype_tag()) / 8);
+        if (prim_type->is_vector()) {
+            // vectors are aligned to their size rounded up to the next power of two
+            uint64_t align = 1;
+            while (align < size * prim_type->length())
+                align *= 2;
+            result = Layout{align, align};
+        } else {
+            result = Layout{size, size};
+        }
+    } else if (auto ptr_type = type->isa<PtrType>()) {
+        if (!ptr_type->is_vector())
+            result = Layout{8, 8};
+    } else if (auto array_type = type->isa<DefiniteArrayType>()) {
+        if (auto elem = layout(array_type->elem_type()))
+            result = Layout{elem->size * array_type->dim(), elem->align};
+    } else if (auto struct_type = type->isa<StructType>()) {
+        result = reorder(struct_type);
+    } else if (type->isa<TupleType>()) {
+        Array<Layout> fields(type->num_ops());
+        bool known = true;
+        for (size_t i = 0, e = fields.size(); known && i != e; ++i) {
+            if (auto field = layout(type->op(i)))
+                fields[i] = *field;
+            else
+                known = false;
+        }
+        if (known)
+            result = thorin::layout(fields);
+    }
+
+    return layouts_[type] = result;
+}
+
+/// Finds the order of the fields of @p struct_type with the least padding and returns the resulting layout.
+std::optional<Layout> FieldReorderer::reorder(const StructType* struct_type) {
+    auto n = struct_type->num_ops();
+    Array<Layout> fields(n);
+    for (size_t i = 0; i != n; ++i) {
+        auto field = layout(struct_type->op(i));
+        if (!field)
+            return std::nullopt;
+        fields[i] = *field;
+    }
+
+    auto old_layout = thorin::layout(fields);
+    if (pinned_.contains(struct_type) || n < 2)
+        return old_layout;
+
+    auto& accesses = accesses_[struct_type];
+    accesses.resize(n);
+    Array<size_t> order(n, [](size_t i) { return i; });
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (fields[a].align != fields[b].align) return fields[a].align > fields[b].align;
+        if (fields[a].size  != fields[b].size)  return fields[a].size  > fields[b].size;
+        return accesses[a] > accesses[b];
+    });
+
+    Array<Layout> new_fields(n, [&](size_t i) { return fields[order[i]]; });
+    auto new_layout = thorin::layout(new_fields);
+    if (new_layout.size >= old_layout.size)
+        return old_layout;
+
+    Array<size_t> old2new(n);
+    for (size_t i = 0; i != n; ++i)
+        old2new[order[i]] = i;
+    old2new_[struct_type] = std::move(old2new);
+
+    world().ILOG("reordered the fields of {}: {} instead of {} bytes", struct_type, new_layout.size, old_layout.size);
+    return new_layout;
+}
+
+/// Adjusts @p primop to the new order of the fields - in place, just as @p Def::replace updates the uses of a @p Def.
+void FieldReorderer::remap(const PrimOp* primop) {
+    auto def = const_cast<PrimOp*>(primop);
+
+    if (auto struct_agg = primop->isa<StructAgg>()) {
+        if (auto old2new = old2new_.lookup(struct_agg->type())) {
+            Array<const Def*> ops(struct_agg->ops());
+            def->unset_ops();
+            for (size_t i = 0, e = ops.size(); i != e; ++i)
+                def->set_op((*old2new)[i], ops[i]);
+        }
+    } else if (auto struct_type = struct_index(primop)) {
+        if (auto old2new = old2new_.lookup(struct_type)) {
+            auto index = primop->op(1);
+            auto new_index = (*old2new)[primlit_value<size_t>(index)];
+            def->unset_op(1);
+            def->set_op(1, world().cast(index->type(), world().literal_qu64(new_index, index->debug()), index->debug()));
+        }
+    }
+}
+
+void reorder_fields(World& world) {
+    world.VLOG("start reorder_fields");
+    FieldReorderer(world).run();
+    world.VLOG("end reorder_fields");
+    debug_verify(world);
+}
+
+}
@@ -0,0 +1,19 @@
+#ifndef THORIN_TRANSFORM_REORDER_FIELDS_H
+#define THORIN_TRANSFORM_REORDER_FIELDS_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Reorders the fields of @p StructType%s to minimize their padding.
+ * Fields are sorted by decreasing alignment, then by decreasing size and finally by the number of accesses, so hot fields share a cache line.
+ * A @p StructType is left as is if it occurs in the type of an external @p Continuation or of a @p Bitcast - then, its layout is observable.
+ * All @p StructAgg%s as well as the indices of @p Extract%s, @p Insert%s and @p LEA%s into a reordered type are remapped.
+ * The bytes saved are reported per type.
+ */
+void reorder_fields(World&);
+
+}
+
+#endif
@@ -1,11 +1,15 @@
 #include "thorin/analyses/scope.h"
 #include "thorin/analyses/schedule.h"
+#include "thorin/util/persistent_map.h"
 #include "thorin/world.h"
 
 namespace thorin {
 
 class ResolveLoads {
 public:
+    /// Maps each safe slot/immutable global to its current contents.
+    using SlotMap = PersistentGIDMap<const Def*, const Def*>;
+
     ResolveLoads(World& world)
         : world_(world)
     {}
@@ -22,38 +26,43 @@ public:
         for (auto node : scope.f_cfg().reverse_post_order()) {
             auto continuation = node->continuation();
             for (auto param : continuation->params()) {
-                if (param->type()->isa<MemType>()) {
-                    Def2Def mapping;
-                    resolve_loads(param, mapping);
-                }
+                if (param->type()->isa<MemType>())
+                    resolve_loads(param);
             }
         }
     }
 
-    void resolve_loads(const Def* mem, Def2Def& mapping) {
+    void resolve_loads(const Def* root) {
         // Traverse the tree of memory objects and
         // incrementally build the contents of each
-        // safe slot/immutable global
-        while (mem) {
-            // This loop iterates through all uses, and processes them recursively.
-            // The last use is treated separately to be able to re-use the mapping.
-            auto uses = mem->copy_uses();
-            size_t i = 0, n = uses.size();
-            for (auto it = uses.begin(); i < n; ++i, ++it) {
-                if (i == n - 1) {
-                    mem = process_use(*it, mapping);
-                } else {
-                    Def2Def split_mapping = mapping;
-                    auto next_mem = process_use(*it, split_mapping);
-                    resolve_loads(next_mem, split_mapping);
+        // safe slot/immutable global.
+        // The mapping is persistent, so forking it for each branch of the tree is cheap.
+        std::stack<std::pair<const Def*, SlotMap>> stack;
+        stack.emplace(root, SlotMap());
+
+        while (!stack.empty()) {
+            auto [mem, mapping] = pop(stack);
+            while (mem) {
+                // This loop iterates through all uses and defers all but the last one.
+                // The last use is treated separately to be able to re-use the mapping.
+                auto uses = mem->copy_uses();
+                size_t i = 0, n = uses.size();
+                for (auto it = uses.begin(); i < n; ++i, ++it) {
+                    if (i == n - 1) {
+                        mem = process_use(*it, mapping);
+                    } else {
+                        SlotMap split_mapping = mapping;
+                        if (auto next_mem = process_use(*it, split_mapping))
+                            stack.emplace(next_mem, split_mapping);
+                    }
                 }
+                if (n == 0)
+                    break;
             }
-            if (n == 0)
-                break;
         }
     }
 
-    const Def* process_use(const Def* mem_use, Def2Def& mapping) {
+    const Def* process_use(const Def* mem_use, SlotMap& mapping) {
         if (auto load = mem_use->isa<Load>()) {
             // Try to find the slot corresponding to this load
             auto slot = find_slot(load->ptr());
@@ -78,7 +87,7 @@ public:
                     // If the slot has been found and is safe, try to find a value for it
                     auto slot_value = get_value(slot, mapping);
                     auto stored_value = insert_to_slot(store->ptr(), slot_value, store->val(), store->debug());
-                    mapping[slot] = stored_value;
+                    mapping.set(slot, stored_value);
                 }
             }
             return store->out_mem();
@@ -88,7 +97,7 @@ public:
             for (auto use : frame->uses()) {
                 // All the slots allocated at that point contain bottom
                 assert(use->isa<Slot>());
-                mapping[use.def()] = world_.bottom(use->type()->as<PtrType>()->pointee());
+                mapping.set(use.def(), world_.bottom(use->type()->as<PtrType>()->pointee()));
             }
             return enter->out_mem();
         } else {
@@ -96,17 +105,20 @@ public:
         }
     }
 
-    const Def* get_value(const Def* alloc, Def2Def& mapping) {
-        auto it = mapping.find(alloc);
-        if (it != mapping.end())
-            return it->second;
-        if (auto global = alloc->isa<Global>()) {
+    const Def* get_value(const Def* alloc, SlotMap& mapping) {
+        if (auto value = mapping.lookup(alloc))
+            return *value;
+
+        const Def* value = nullptr;
+        if (auto global = alloc->isa<Global>(); global && !global->is_mutable()) {
             // Immutable globals will remain set to their initial value
-            if (!global->is_mutable())
-                return mapping[alloc] = global->init();
+            value = global->init();
+        } else {
+            // Nothing is known about this allocation yet
+            value = world_.top(alloc->type()->as<PtrType>()->pointee(), alloc->debug());
         }
-        // Nothing is known about this allocation yet
-        return mapping[alloc] = world_.top(alloc->type()->as<PtrType>()->pointee(), alloc->debug());
+        mapping.set(alloc, value);
+        return value;
     }
 
     const Def* extract_from_slot(const Def* ptr, const Def* slot_value, Debug dbg) {
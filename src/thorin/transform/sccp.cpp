@@ -0,0 +1,284 @@
+#include "thorin/transform/sccp.h"
+
+#include <queue>
+
+#include "thorin/continuation.h"
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// The lattice: @p Top - no value seen yet, @p Const - always the @p PrimLit @p lit, @p Bottom - overdefined.
+struct Value {
+    enum Tag { Top, Const, Bottom };
+
+    Value(Tag tag = Top, const Def* lit = nullptr)
+        : tag(tag)
+        , lit(lit)
+    {}
+
+    bool operator==(const Value& other) const { return tag == other.tag && lit == other.lit; }
+    bool operator!=(const Value& other) const { return !(*this == other); }
+
+    Tag tag;
+    const Def* lit;
+};
+
+static Value meet(Value a, Value b) {
+    if (a.tag == Value::Top) return b;
+    if (b.tag == Value::Top) return a;
+    if (a == b) return a;
+    return Value::Bottom;
+}
+
+class SCCP {
+public:
+    SCCP(World& world)
+        : world_(world)
+    {}
+
+    World& world() const { return world_; }
+    void run();
+    size_t rewrite();
+
+private:
+    bool is_known(Continuation*);
+    void reach(Continuation*, bool escaping);
+    void escape(const Def*);
+    void update(const Param*, Value);
+    void enqueue_users(const Def*);
+    void visit(Continuation*);
+    Value eval(const Def*, DefMap<Value>&);
+    Value lookup(const Param*) const;
+
+    World& world_;
+    ContinuationMap<bool> known_;
+    ContinuationSet reachable_;
+    std::queue<Continuation*> queue_;
+    ParamMap<Value> param2value_;
+    DefSet escaped_;
+};
+
+/// Only calls a @p Continuation which is neither visible from outside nor passed around - thus, we see all values of its params.
+bool SCCP::is_known(Continuation* continuation) {
+    if (auto i = known_.find(continuation); i != known_.end())
+        return i->second;
+
+    bool known = !continuation->empty() && !continuation->is_external() && !continuation->is_intrinsic();
+    for (auto use : continuation->uses())
+        known &= use->isa_continuation() && use.index() == 0;
+    return known_[continuation] = known;
+}
+
+Value SCCP::lookup(const Param* param) const {
+    auto i = param2value_.find(param);
+    return i != param2value_.end() ? i->second : Value();
+}
+
+void SCCP::reach(Continuation* continuation, bool escaping) {
+    if (continuation->is_intrinsic())
+        return;
+    if (escaping || !is_known(continuation)) {
+        for (auto param : continuation->params())
+            update(param, Value::Bottom);
+    }
+    if (reachable_.emplace(continuation).second)
+        queue_.push(continuation);
+}
+
+/// All @p Continuation%s referenced by @p def may be invoked by someone we don't know.
+void SCCP::escape(const Def* def) {
+    std::vector<const Def*> stack;
+    auto push = [&](const Def* def) {
+        if (escaped_.emplace(def).second)
+            stack.push_back(def);
+    };
+
+    push(def);
+    while (!stack.empty()) {
+        auto def = stack.back();
+        stack.pop_back();
+        if (auto continuation = def->isa_continuation()) {
+            reach(continuation, true);
+        } else if (def->isa<PrimOp>()) {
+            for (auto op : def->ops())
+                push(op);
+        }
+    }
+}
+
+void SCCP::update(const Param* param, Value value) {
+    auto& cur = param2value_[param];
+    auto nvalue = meet(cur, value);
+    if (nvalue != cur) {
+        cur = nvalue;
+        enqueue_users(param);
+    }
+}
+
+void SCCP::enqueue_users(const Def* def) {
+    DefSet done;
+    std::vector<const Def*> stack;
+    stack.push_back(def);
+    while (!stack.empty()) {
+        auto def = stack.back();
+        stack.pop_back();
+        for (auto use : def->uses()) {
+            if (!done.emplace(use.def()).second)
+                continue;
+            if (auto continuation = use->isa_continuation()) {
+                if (reachable_.contains(continuation))
+                    queue_.push(continuation);
+            } else {
+                stack.push_back(use.def());
+            }
+        }
+    }
+}
+
+Value SCCP::eval(const Def* def, DefMap<Value>& cache) {
+    if (auto i = cache.find(def); i != cache.end())
+        return i->second;
+
+    if (def->isa<PrimLit>())
+        return cache[def] = Value(Value::Const, def);
+    if (auto param = def->isa<Param>())
+        return cache[def] = lookup(param);
+
+    auto primop = def->isa<PrimOp>();
+    if (!primop || !(primop->isa<ArithOp>() || primop->isa<Cmp>() || primop->isa<ConvOp>() || primop->isa<Select>()))
+        return cache[def] = Value::Bottom;
+
+    if (auto select = primop->isa<Select>()) {
+        auto cond = eval(select->cond(), cache);
+        if (cond.tag == Value::Const)
+            return cache[def] = eval(cond.lit->as<PrimLit>()->value().get_bool() ? select->tval() : select->fval(), cache);
+    }
+
+    Array<const Def*> nops(primop->num_ops());
+    bool top = false;
+    for (size_t i = 0, e = primop->num_ops(); i != e; ++i) {
+        auto value = eval(primop->op(i), cache);
+        if (value.tag == Value::Bottom)
+            return cache[def] = Value::Bottom;
+        top |= value.tag == Value::Top;
+        nops[i] = value.lit;
+    }
+    if (top)
+        return cache[def] = Value::Top;
+
+    auto folded = primop->rebuild(world(), primop->type(), nops);
+    return cache[def] = folded->isa<PrimLit>() ? Value(Value::Const, folded) : Value(Value::Bottom);
+}
+
+void SCCP::visit(Continuation* continuation) {
+    if (continuation->empty())
+        return;
+
+    DefMap<Value> cache;
+    auto callee = continuation->callee()->isa_continuation();
+    if (callee && callee->intrinsic() == Intrinsic::Branch) {
+        auto cond = eval(continuation->arg(0), cache);
+        auto t = continuation->arg(1)->as_continuation(), f = continuation->arg(2)->as_continuation();
+        if (cond.tag == Value::Const) {
+            reach(cond.lit->as<PrimLit>()->value().get_bool() ? t : f, false);
+        } else if (cond.tag == Value::Bottom) {
+            reach(t, false);
+            reach(f, false);
+        }
+        return;
+    }
+
+    if (callee && callee->intrinsic() == Intrinsic::Match) {
+        auto val = eval(continuation->arg(0), cache);
+        if (val.tag == Value::Top)
+            return;
+
+        Continuation* target = nullptr;
+        for (size_t i = 2, e = continuation->num_args(); i != e; ++i) {
+            auto pattern = world().extract(continuation->arg(i), 0_s);
+            auto cont = world().extract(continuation->arg(i), 1)->as_continuation();
+            if (val.tag == Value::Bottom)
+                reach(cont, false);
+            else if (pattern == val.lit)
+                target = cont;
+        }
+        if (val.tag == Value::Bottom || target == nullptr)
+            reach(continuation->arg(1)->as_continuation(), false);
+        else
+            reach(target, false);
+        return;
+    }
+
+    if (callee && is_known(callee)) {
+        reach(callee, false);
+        for (size_t i = 0, e = continuation->num_args(); i != e; ++i)
+            update(callee->param(i), eval(continuation->arg(i), cache));
+    } else {
+        escape(continuation->callee());
+    }
+
+    // the return continuation and other continuations passed along may be invoked by anyone
+    for (auto arg : continuation->args())
+        escape(arg);
+}
+
+void SCCP::run() {
+    for (auto continuation : world().continuations()) {
+        if (continuation->is_exported())
+            reach(continuation, true);
+    }
+
+    while (!queue_.empty())
+        visit(pop(queue_));
+}
+
+size_t SCCP::rewrite() {
+    size_t num = 0;
+    for (auto continuation : reachable_) {
+        for (auto param : continuation->params()) {
+            auto value = lookup(param);
+            if (value.tag == Value::Const && !param->is_replaced()) {
+                world().DLOG("{} is constant {}", param, value.lit);
+                param->replace(value.lit);
+                ++num;
+            }
+        }
+    }
+
+    // now, the conditions become literals and jump folds the branches
+    for (auto continuation : reachable_) {
+        if (continuation->empty())
+            continue;
+        auto callee = continuation->callee()->isa_continuation();
+        if (!callee || (callee->intrinsic() != Intrinsic::Branch && callee->intrinsic() != Intrinsic::Match))
+            continue;
+
+        DefMap<Value> cache;
+        auto value = eval(continuation->arg(0), cache);
+        if (value.tag == Value::Const && continuation->arg(0) != value.lit) {
+            world().DLOG("fold {} in {}", callee, continuation);
+            continuation->update_arg(0, value.lit);
+            ++num;
+        }
+    }
+
+    return num;
+}
+
+void sccp(World& world) {
+    world.VLOG("start sccp");
+
+    SCCP sccp(world);
+    sccp.run();
+    auto num = sccp.rewrite();
+
+    world.VLOG("folded {} params and branches", num);
+    world.VLOG("end sccp");
+    debug_verify(world);
+    if (num != 0)
+        world.cleanup();
+}
+
+}
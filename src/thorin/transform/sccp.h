@@ -0,0 +1,18 @@
+#ifndef THORIN_TRANSFORM_SCCP_H
+#define THORIN_TRANSFORM_SCCP_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Interprocedural sparse conditional constant propagation.
+ * Starting from the exported @p Continuation%s, it tracks which @p Continuation%s are reachable and which @p Param%s are constant.
+ * @p Param%s proven constant are replaced by their value and @c branch / @c match edges that are never taken are folded away.
+ * Unlike @p partial_evaluation, this never duplicates code.
+ */
+void sccp(World&);
+
+}
+
+#endif
@@ -0,0 +1,340 @@
+#include "thorin/transform/slp_vectorize.h"
+
+#include <algorithm>
+#include <map>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+SLPConfig SLPConfig::get(Target target) {
+    switch (target) {
+        case Target::CPU: return {8};
+        // CUDA and the LLVM GPU backends have no vector arithmetic - kernels for OpenCL are packed by the DeviceBackends
+        case Target::GPU: return {1};
+        case Target::HLS: return {1};
+    }
+    THORIN_UNREACHABLE;
+}
+
+/// Number of accesses to look at when ordering a group along its @c mem chain.
+static constexpr size_t MaxChain = 64;
+/// Operands of packed operations deeper than this are gathered.
+static constexpr size_t MaxDepth = 8;
+
+static bool is_scalar(const Type* type) {
+    auto prim_type = type->isa<PrimType>();
+    return prim_type != nullptr && !prim_type->is_vector();
+}
+
+/// The element <tt>index + offset</tt> of the array @c ptr points to - @c ptr is @c nullptr if an address is no array element.
+struct Element {
+    const Def* ptr = nullptr;
+    const Def* index = nullptr;
+    int64_t offset = 0;
+};
+
+static Element element(const Def* ptr) {
+    auto lea = ptr->isa<LEA>();
+    if (lea == nullptr || !lea->ptr_pointee()->isa<ArrayType>())
+        return {};
+
+    auto index = lea->index();
+    if (index->isa<PrimLit>())
+        return {lea->ptr(), nullptr, primlit_value<int64_t>(index)};
+    if (auto add = index->isa<ArithOp>(); add != nullptr && add->arithop_tag() == ArithOp_add) {
+        if (add->rhs()->isa<PrimLit>()) return {lea->ptr(), add->lhs(), primlit_value<int64_t>(add->rhs())};
+        if (add->lhs()->isa<PrimLit>()) return {lea->ptr(), add->rhs(), primlit_value<int64_t>(add->lhs())};
+    }
+    return {lea->ptr(), index, 0};
+}
+
+/// Do the accesses of @p group address consecutive elements of the same array in this order?
+static bool is_consecutive(ArrayRef<const Access*> group) {
+    auto first = element(group.front()->ptr());
+    if (first.ptr == nullptr)
+        return false;
+    for (size_t i = 1, e = group.size(); i != e; ++i) {
+        auto next = element(group[i]->ptr());
+        if (next.ptr != first.ptr || next.index != first.index || next.offset != first.offset + int64_t(i))
+            return false;
+    }
+    return true;
+}
+
+/// A pointer to the vector of @p num_lanes elements that starts at the array element @p ptr.
+static const Def* vector_ptr(const Def* ptr, size_t num_lanes) {
+    auto& world = ptr->world();
+    auto ptr_type = ptr->type()->as<PtrType>();
+    auto elem_type = ptr_type->pointee()->as<PrimType>();
+    auto vector_type = world.prim_type(elem_type->primtype_tag(), num_lanes);
+    return world.bitcast(world.ptr_type(vector_type, 1, ptr_type->device(), ptr_type->addr_space()), ptr, ptr->debug());
+}
+
+/**
+ * Orders the accesses of @p group along their @c mem chain.
+ * Returns the accesses from the last member of @p group upwards to the first one - or nothing if they do not lie on a single chain.
+ */
+static std::vector<const Access*> chain(ArrayRef<const Access*> group) {
+    for (auto last : group) {
+        std::vector<const Access*> path;
+        size_t found = 0;
+        for (const Access* access = last; access != nullptr && path.size() != MaxChain; access = MemorySSA::access(access->mem())->isa<Access>()) {
+            path.push_back(access);
+            if (std::find(group.begin(), group.end(), access) != group.end() && ++found == group.size())
+                return path;
+        }
+    }
+    return {};
+}
+
+class SLPVectorizer {
+public:
+    SLPVectorizer(const Scope& scope, const SLPConfig& config)
+        : mssa_(scope)
+        , config_(config)
+    {}
+
+    World& world() const { return mssa_.world(); }
+    void run();
+
+private:
+    /// A vector @p Load that replaces the scalar @c loads - @c first is the one that comes first on the @c mem chain.
+    struct LoadPack {
+        std::vector<const Access*> loads;
+        const Access* first;
+        const Def* load;
+    };
+
+    bool pack(ArrayRef<const Access*> stores);
+    bool is_independent(ArrayRef<const Access*> path, ArrayRef<const Access*> group, bool loads);
+    const Def* build(Defs lanes, size_t depth);
+    const Def* build_load(Defs lanes);
+    const Def* build_op(Defs lanes, size_t depth);
+
+    MemorySSA mssa_;
+    const SLPConfig& config_;
+    std::map<std::vector<const Def*>, const Def*> packs_;
+    std::vector<LoadPack> load_packs_;
+    DefSet tree_;
+    int64_t benefit_ = 0;
+};
+
+void SLPVectorizer::run() {
+    // group the scalar stores by the array and the non-constant part of their index
+    std::map<std::pair<const Def*, const Def*>, size_t> key2group;
+    std::vector<std::vector<const Access*>> groups;
+    for (auto memop : mssa_.accesses()) {
+        auto store = memop->isa<Store>();
+        if (store == nullptr || !is_scalar(store->val()->type()))
+            continue;
+        auto elem = element(store->ptr());
+        if (elem.ptr == nullptr)
+            continue;
+        auto [i, inserted] = key2group.emplace(std::make_pair(elem.ptr, elem.index), groups.size());
+        if (inserted)
+            groups.emplace_back();
+        groups[i->second].push_back(store);
+    }
+
+    size_t num = 0;
+    for (auto& group : groups) {
+        std::stable_sort(group.begin(), group.end(), [&](auto a, auto b) { return element(a->ptr()).offset < element(b->ptr()).offset; });
+
+        for (size_t i = 0, e = group.size(); i != e;) {
+            // the longest run of consecutive elements starting at i
+            size_t end = i + 1;
+            while (end != e && element(group[end]->ptr()).offset == element(group[end - 1]->ptr()).offset + 1)
+                ++end;
+
+            size_t n = 1;
+            while (n * 2 <= std::min(end - i, config_.max_lanes))
+                n *= 2;
+            for (; n >= 2; n /= 2) {
+                if (pack(ArrayRef<const Access*>(group.data() + i, n)))
+                    break;
+            }
+
+            if (n >= 2) {
+                i += n;
+                ++num;
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    if (num != 0)
+        world().ILOG("packed {} groups of stores into vectors in {}", num, mssa_.scope().entry());
+}
+
+/// Are the accesses on @p path other than those of @p group independent of @p group - so may the accesses of @p group be merged?
+bool SLPVectorizer::is_independent(ArrayRef<const Access*> path, ArrayRef<const Access*> group, bool loads) {
+    for (auto access : path) {
+        if (std::find(group.begin(), group.end(), access) != group.end() || (loads && access->isa<Load>()))
+            continue;
+        for (auto member : group) {
+            if (mssa_.alias(access->ptr(), member->ptr()) != AliasResult::No)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool SLPVectorizer::pack(ArrayRef<const Access*> stores) {
+    if (!is_consecutive(stores))
+        return false;
+
+    // the stores are merged into the last one - so no one else may observe the memory states in between
+    auto path = chain(stores);
+    if (path.empty() || !is_independent(path, stores, false))
+        return false;
+    for (size_t i = 1, e = path.size(); i != e; ++i) {
+        if (MemorySSA::out_mem(path[i])->num_uses() != 1)
+            return false;
+    }
+
+    auto n = stores.size();
+    packs_.clear();
+    load_packs_.clear();
+    tree_.clear();
+    for (auto store : stores)
+        tree_.emplace(store);
+    benefit_ = int64_t(n) - 1;
+
+    Array<const Def*> vals(n, [&](size_t i) { return stores[i]->as<Store>()->val(); });
+    auto val = build(vals, 0);
+    if (benefit_ <= 0)
+        return false;
+
+    for (auto& [loads, first, load] : load_packs_) {
+        auto vector = world().extract(load, 1);
+        for (size_t i = 0, e = loads.size(); i != e; ++i) {
+            auto mem = loads[i] == first ? world().extract(load, 0_s) : loads[i]->mem();
+            loads[i]->replace(world().tuple({mem, world().extract(vector, u32(i))}, loads[i]->debug()));
+        }
+    }
+
+    auto last = path.front();
+    for (auto store : stores) {
+        if (store != last)
+            store->replace(store->mem());
+    }
+    last->replace(world().store(last->mem(), vector_ptr(stores.front()->ptr(), n), val, last->debug()));
+    return true;
+}
+
+/// Packs the scalar @p lanes into a vector and accounts the costs in @p benefit_.
+const Def* SLPVectorizer::build(Defs lanes, size_t depth) {
+    std::vector<const Def*> key(lanes.begin(), lanes.end());
+    if (auto i = packs_.find(key); i != packs_.end())
+        return i->second;
+
+    const Def* result = nullptr;
+    if (std::all_of(lanes.begin(), lanes.end(), [&](const Def* lane) { return lane == lanes.front(); })) {
+        if (!lanes.front()->isa<PrimLit>())
+            benefit_ -= 1;
+        result = world().splat(lanes.front(), lanes.size());
+    } else if (std::all_of(lanes.begin(), lanes.end(), [&](const Def* lane) { return lane->isa<PrimLit>(); })) {
+        result = world().vector(lanes);
+    } else if (depth != MaxDepth) {
+        result = build_load(lanes);
+        if (result == nullptr)
+            result = build_op(lanes, depth);
+    }
+
+    if (result == nullptr) {
+        benefit_ -= lanes.size();
+        result = world().vector(lanes);
+    }
+    return packs_[key] = result;
+}
+
+/// A vector @p Load if the @p lanes are the values of @p Load%s from consecutive elements - @c nullptr otherwise.
+const Def* SLPVectorizer::build_load(Defs lanes) {
+    std::vector<const Access*> loads;
+    for (auto lane : lanes) {
+        auto load = Load::is_out_val(lane);
+        if (load == nullptr || std::find(loads.begin(), loads.end(), load) != loads.end())
+            return nullptr;
+        for (auto& load_pack : load_packs_) {
+            if (std::find(load_pack.loads.begin(), load_pack.loads.end(), load) != load_pack.loads.end())
+                return nullptr;
+        }
+        loads.push_back(load);
+    }
+
+    if (!is_consecutive(loads))
+        return nullptr;
+
+    // the loads are merged into the first one - no store in between may write to the loaded elements
+    auto path = chain(loads);
+    if (path.empty() || !is_independent(path, loads, true))
+        return nullptr;
+
+    auto first = path.back();
+    auto load = world().load(first->mem(), vector_ptr(loads.front()->ptr(), loads.size()), first->debug());
+    load_packs_.push_back({loads, first, load});
+    benefit_ += int64_t(loads.size()) - 1;
+    return world().extract(load, 1);
+}
+
+/// A vector operation if the @p lanes are isomorphic @p ArithOp%s, @p MathOp%s or @p Cast%s - @c nullptr otherwise.
+const Def* SLPVectorizer::build_op(Defs lanes, size_t depth) {
+    auto first = lanes.front()->isa<PrimOp>();
+    if (first == nullptr || !(first->isa<ArithOp>() || first->isa<MathOp>() || first->isa<Cast>()))
+        return nullptr;
+    for (auto lane : lanes) {
+        if (lane->tag() != first->tag() || lane->type() != first->type() || lane->num_ops() != first->num_ops())
+            return nullptr;
+        for (size_t i = 0, e = lane->num_ops(); i != e; ++i) {
+            if (lane->op(i)->type() != first->op(i)->type())
+                return nullptr;
+        }
+    }
+
+    // a lane that is also used elsewhere must stay - it does not save anything
+    int64_t saved = 0;
+    for (auto lane : lanes) {
+        if (std::all_of(lane->uses().begin(), lane->uses().end(), [&](const Use& use) { return tree_.contains(use.def()); }))
+            ++saved;
+    }
+    for (auto lane : lanes)
+        tree_.emplace(lane);
+    benefit_ += saved - 1;
+
+    auto n = lanes.size();
+    Array<const Def*> ops(first->num_ops(), [&](size_t i) {
+        Array<const Def*> op_lanes(n, [&](size_t j) { return lanes[j]->op(i); });
+        return build(op_lanes, depth + 1);
+    });
+
+    auto dbg = first->debug();
+    if (auto arithop = first->isa<ArithOp>())
+        return world().arithop(arithop->arithop_tag(), ops[0], ops[1], dbg);
+    if (auto mathop = first->isa<MathOp>())
+        return world().mathop(mathop->mathop_tag(), ops, dbg);
+    return world().cast(world().prim_type(first->type()->as<PrimType>()->primtype_tag(), n), ops[0], dbg);
+}
+
+void slp_vectorize(World& world, const SLPConfig& config) {
+    if (config.max_lanes < 2)
+        return;
+
+    world.VLOG("start slp_vectorize");
+    // kernels are packed - if at all - by their backend: the host target does not tell what vector types the device has
+    auto kernels = accelerator_code(world, [] (Continuation* intrinsic) { return intrinsic->is_device_backend(); });
+    Scope::for_each(world, [&](Scope& scope) {
+        if (!kernels.contains(scope.entry()))
+            SLPVectorizer(scope, config).run();
+    });
+    world.VLOG("end slp_vectorize");
+
+    debug_verify(world);
+}
+
+}
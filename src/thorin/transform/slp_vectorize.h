@@ -0,0 +1,31 @@
+#ifndef THORIN_TRANSFORM_SLP_VECTORIZE_H
+#define THORIN_TRANSFORM_SLP_VECTORIZE_H
+
+#include <cstddef>
+
+namespace thorin {
+
+class World;
+enum class Target;
+
+/// Tuning knobs of @p slp_vectorize.
+struct SLPConfig {
+    /// Maximum number of lanes of a vector; less than 2 disables the pass.
+    size_t max_lanes;
+
+    static SLPConfig get(Target);
+};
+
+/**
+ * Packs isomorphic scalar computations into vectors (superword-level parallelism).
+ * Seeds are @p Store%s of @p PrimType values to adjacent elements of the same array along a single @c mem chain.
+ * Starting from the stored values, lanes that are @p ArithOp%s, @p MathOp%s or @p Cast%s of the same kind become one vector operation and
+ * @p Load%s from adjacent elements become one vector @p Load; any other lanes are gathered into a @p Vector.
+ * A group is only packed if this saves more operations than the gathering costs.
+ * Kernels passed to a GPU or HLS backend are left alone - the world of the respective backend decides.
+ */
+void slp_vectorize(World&, const SLPConfig& config);
+
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "thorin/transform/split_effects.h"
+
+#include <algorithm>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/effect_regions.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+/// The @p Access which is the one and only consumer of the memory state produced by @p memop - if any.
+static const Access* next_access(const Def* memop) {
+    auto mem = MemorySSA::out_mem(memop);
+    if (mem == nullptr || mem->num_uses() != 1)
+        return nullptr;
+    auto use = *mem->uses().begin();
+    auto access = use->isa<Access>();
+    return access != nullptr && use.index() == 0 ? access : nullptr;
+}
+
+/// Rebuilds @p access on top of the memory state @p mem and returns the new access.
+static const Def* rebuild(const Access* access, const Def* mem) {
+    auto& world = access->world();
+    if (auto load = access->isa<Load>())
+        return world.load(mem, load->ptr(), load->debug());
+    auto store = access->as<Store>();
+    return world.store(mem, store->ptr(), store->val(), store->debug());
+}
+
+/// The memory state after the rebuilt @p access.
+static const Def* out_mem(const Access* access, const Def* rebuilt) {
+    return access->isa<Load>() ? access->world().extract(rebuilt, 0_s) : rebuilt;
+}
+
+class EffectSplitter {
+public:
+    EffectSplitter(const Scope& scope, bool restrict)
+        : regions_(scope, restrict)
+    {}
+
+    World& world() const { return regions_.world(); }
+    void run();
+
+private:
+    bool split(const std::vector<const Access*>& chain);
+
+    EffectRegions regions_;
+};
+
+void EffectSplitter::run() {
+    if (regions_.num_regions() < 2)
+        return;
+
+    size_t num = 0;
+    for (auto memop : regions_.mssa().accesses()) {
+        auto access = memop->isa<Access>();
+        if (access == nullptr || access->is_replaced())
+            continue;
+        if (auto prev = MemorySSA::access(access->mem())->isa<Access>(); prev != nullptr && next_access(prev) == access)
+            continue; // not the first access of its chain
+
+        std::vector<const Access*> chain;
+        for (auto a = access; a != nullptr; a = next_access(a))
+            chain.push_back(a);
+        if (split(chain))
+            ++num;
+    }
+
+    if (num != 0)
+        world().ILOG("split {} memory chains into {} effect regions in {}", num, regions_.num_regions(), regions_.scope().entry());
+}
+
+bool EffectSplitter::split(const std::vector<const Access*>& chain) {
+    auto end = MemorySSA::out_mem(chain.back());
+    if (end == nullptr)
+        return false;
+
+    // index of each region touched within mems - in order of the first access
+    std::vector<size_t> region2index(regions_.num_regions(), size_t(-1));
+    size_t num = 0;
+    for (auto access : chain) {
+        auto& index = region2index[regions_.region(access)];
+        if (index == size_t(-1))
+            index = num++;
+    }
+    if (num < 2)
+        return false;
+
+    std::vector<const Def*> mems(num, chain.front()->mem());
+    std::vector<const Def*> rebuilt;
+    for (auto access : chain) {
+        auto& mem = mems[region2index[regions_.region(access)]];
+        rebuilt.push_back(rebuild(access, mem));
+        mem = out_mem(access, rebuilt.back());
+    }
+
+    // redirect the consumers of the chain first - the old accesses' out mems get rewired below
+    end->replace(world().join(mems, chain.back()->debug()));
+    for (size_t i = 0, e = chain.size(); i != e; ++i) {
+        if (chain[i] != end) // a trailing Store is its own out mem
+            chain[i]->replace(rebuilt[i]);
+    }
+    return true;
+}
+
+void split_effects(World& world, const ContinuationSet& restrict) {
+    world.VLOG("start split_effects");
+
+    Scope::for_each(world, [&](const Scope& scope) {
+        EffectSplitter splitter(scope, restrict.contains(scope.entry()));
+        splitter.run();
+    });
+
+    world.VLOG("end split_effects");
+    debug_verify(world);
+}
+
+//------------------------------------------------------------------------------
+
+void join_effects(World& world) {
+    std::vector<const Join*> joins;
+    for (auto primop : world.primops()) {
+        if (auto join = primop->isa<Join>())
+            joins.push_back(join);
+    }
+    if (joins.empty())
+        return;
+
+    world.VLOG("start join_effects");
+
+    // inner joins first - nested ones stem from splitting a chain again
+    std::sort(joins.begin(), joins.end(), [](const Join* a, const Join* b) { return a->gid() < b->gid(); });
+    for (auto join : joins) {
+        if (join->is_replaced())
+            continue;
+
+        auto mem = join->mems().front();
+        for (auto in : join->mems().skip_front()) {
+            // all memory states on the chain built so far - where the next chain branches off
+            DefSet done;
+            for (auto cur = mem;; cur = MemorySSA::access(cur)->as<Access>()->mem()) {
+                done.emplace(cur);
+                if (!MemorySSA::access(cur)->isa<Access>())
+                    break;
+            }
+
+            std::vector<const Access*> chain;
+            auto cur = in;
+            for (; !done.contains(cur); cur = chain.back()->mem()) {
+                auto access = MemorySSA::access(cur)->isa<Access>();
+                assert(access != nullptr && "chains of a join must branch off the same memory state");
+                chain.push_back(access);
+            }
+            std::reverse(chain.begin(), chain.end());
+
+            std::vector<const Def*> rebuilt;
+            for (auto access : chain) {
+                rebuilt.push_back(rebuild(access, mem));
+                mem = out_mem(access, rebuilt.back());
+            }
+            for (size_t i = 0, e = chain.size(); i != e; ++i)
+                chain[i]->replace(rebuilt[i]);
+        }
+        join->replace(mem);
+    }
+
+    world.VLOG("end join_effects");
+    debug_verify(world);
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef THORIN_TRANSFORM_SPLIT_EFFECTS_H
+#define THORIN_TRANSFORM_SPLIT_EFFECTS_H
+
+#include "thorin/continuation.h"
+
+namespace thorin {
+
+class World;
+
+/**
+ * Splits the single @c mem chain into independent chains - one per region found by @p EffectRegions.
+ * Each straight-line sequence of @p Load%s and @p Store%s touching more than one region is rewired such that each access only depends on the previous access to its region.
+ * The chains are merged again by a @p Join right before the next call, intrinsic, jump or any other consumer of the memory state.
+ * Thus, the @p Scheduler and the emitters may place and emit the accesses of different regions independently of each other.
+ * The pointer @p Param%s of the entry of each @p Scope in @p restrict point to distinct objects.
+ */
+void split_effects(World&, const ContinuationSet& restrict = {});
+
+/// Undoes @p split_effects by threading all chains merged by a @p Join one after another again - all other passes expect a single chain.
+void join_effects(World&);
+
+}
+
+#endif
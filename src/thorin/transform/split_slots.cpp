@@ -1,66 +1,135 @@
 #include "thorin/primop.h"
 #include "thorin/world.h"
 #include "thorin/analyses/scope.h"
-#include "thorin/analyses/schedule.h"
 #include "thorin/analyses/verify.h"
 #include "thorin/transform/split_slots.h"
 
 namespace thorin {
 
-struct IndexHash {
-    static hash_t hash(u32 u) { return u; } // TODO bad hash function
-    static bool eq(u32 a, u32 b) { return a == b; }
-    static u32 sentinel() { return 0xFFFFFFFF; }
-};
+/// Arrays with at most this many elements are also split if accessed with dynamic indices.
+static const u64 max_dynamic_dim = 8;
 
-static void split(const Slot* slot) {
-    auto array_type = slot->alloced_type()->as<DefiniteArrayType>();
-    auto dim = array_type->dim();
-    auto elem_type = array_type->elem_type();
+static size_t num_elems(const Type* type) {
+    if (auto array_type = type->isa<DefiniteArrayType>())
+        return array_type->dim();
+    if (type->isa<StructType>())
+        return type->num_ops();
+    // Thorin has no 1-tuples
+    if (type->isa<TupleType>() && type->num_ops() > 1)
+        return type->num_ops();
+    return 0;
+}
+
+static const Type* elem_type(const Type* type, size_t i) {
+    if (auto array_type = type->isa<DefiniteArrayType>())
+        return array_type->elem_type();
+    return type->op(i);
+}
 
-    HashMap<u32, const Def*, IndexHash> new_slots;
+static const Def* aggregate(World& world, const Type* type, Defs elems, Debug dbg) {
+    if (auto array_type = type->isa<DefiniteArrayType>())
+        return world.definite_array(array_type->elem_type(), elems, dbg);
+    if (auto struct_type = type->isa<StructType>())
+        return world.struct_agg(struct_type, elems, dbg);
+    return world.tuple(elems, dbg);
+}
+
+static void split(const Slot* slot) {
+    auto type = slot->alloced_type();
+    auto num = num_elems(type);
     auto& world = slot->world();
+    world.DLOG("split {}", slot);
 
-    auto elem_slot = [&] (u32 index) {
-        if (!new_slots.contains(index))
-            new_slots[index] = world.slot(elem_type, slot->frame(), slot->debug());
-        return new_slots[index];
+    std::vector<const Def*> new_slots(num, nullptr);
+    auto elem_slot = [&] (size_t i) {
+        if (new_slots[i] == nullptr)
+            new_slots[i] = world.slot(elem_type(type, i), slot->frame(), slot->debug());
+        return new_slots[i];
+    };
+
+    // loads all elements and returns the new mem
+    auto load_elems = [&] (const Def* mem, Array<const Def*>& elems, Debug dbg) {
+        for (size_t i = 0; i != num; ++i) {
+            auto tuple = world.load(mem, elem_slot(i), dbg);
+            elems[i] = world.extract(tuple, 1_u32, dbg);
+            mem = world.extract(tuple, 0_u32, dbg);
+        }
+        return mem;
+    };
+
+    auto is_index = [&] (const Def* index, size_t i, Debug dbg) {
+        return world.cmp_eq(index, world.cast(index->type(), world.literal_qu64(i, {})), dbg);
     };
 
     for (auto use : slot->copy_uses()) {
         if (auto lea = use->isa<LEA>()) {
-            lea->replace(elem_slot(lea->index()->as<PrimLit>()->value().get_u32()));
+            if (lea->index()->isa<PrimLit>()) {
+                lea->replace(elem_slot(primlit_value<u64>(lea->index())));
+                continue;
+            }
+
+            // dynamic index: load/store all elements and pick the right one
+            auto index = lea->index();
+            for (auto lea_use : lea->copy_uses()) {
+                if (auto load = lea_use->isa<Load>()) {
+                    Array<const Def*> elems(num);
+                    auto mem = load_elems(load->mem(), elems, load->debug());
+                    auto val = elems.back();
+                    for (size_t i = num - 1; i-- != 0;)
+                        val = world.select(is_index(index, i, load->debug()), elems[i], val, load->debug());
+                    load->replace(world.tuple({ mem, val }, load->debug()));
+                } else {
+                    auto store = lea_use->as<Store>();
+                    Array<const Def*> elems(num);
+                    auto mem = load_elems(store->mem(), elems, store->debug());
+                    for (size_t i = 0; i != num; ++i) {
+                        auto val = world.select(is_index(index, i, store->debug()), store->val(), elems[i], store->debug());
+                        mem = world.store(mem, elem_slot(i), val, store->debug());
+                    }
+                    store->replace(mem);
+                }
+            }
         } else if (auto store = use->isa<Store>()) {
-            auto in_mem = store->op(0);
-            for (size_t i = 0, e = dim; i != e; ++i) {
-                auto elem = world.extract(store->op(2), i, store->debug());
-                in_mem = world.store(in_mem, elem_slot(i), elem, store->debug());
+            auto mem = store->mem();
+            for (size_t i = 0; i != num; ++i) {
+                auto elem = world.extract(store->val(), i, store->debug());
+                mem = world.store(mem, elem_slot(i), elem, store->debug());
             }
-            store->replace(in_mem);
+            store->replace(mem);
         } else if (auto load = use->isa<Load>()) {
-            auto in_mem = load->op(0);
-            auto array = world.bottom(array_type, load->debug());
-            for (size_t i = 0, e = dim; i != e; ++i) {
-                auto tuple = world.load(in_mem, elem_slot(i), load->debug());
-                auto elem = world.extract(tuple, 1_u32, load->debug());
-                in_mem = world.extract(tuple, 0_u32, load->debug());
-                array = world.insert(array, i, elem, load->debug());
-            }
-            load->replace(world.tuple({ in_mem, array }, load->debug()));
+            Array<const Def*> elems(num);
+            auto mem = load_elems(load->mem(), elems, load->debug());
+            load->replace(world.tuple({ mem, aggregate(world, type, elems, load->debug()) }, load->debug()));
         }
     }
 }
 
+/// Is @p use a @p Load from or a @p Store to the pointer?
+static bool is_access(Use use) {
+    return (use->isa<Load>() || use->isa<Store>()) && use.index() == 1;
+}
+
 static bool can_split(const Slot* slot) {
-    if (!slot->alloced_type()->isa<DefiniteArrayType>())
+    auto type = slot->alloced_type();
+    auto num = num_elems(type);
+    if (num == 0)
         return false;
 
-    // only accept LEAs with constant indices and loads and stores
+    // only accept loads, stores and LEAs with constant indices - or dynamic ones into small arrays, if the LEA is only accessed
     for (auto use : slot->uses()) {
         if (auto lea = use->isa<LEA>()) {
-            if (!lea->index()->no_dep())
-                return false;
-        } else if (!use->isa<Store>() && !use->isa<Load>()) {
+            if (lea->index()->isa<PrimLit>()) {
+                if (primlit_value<u64>(lea->index()) >= num)
+                    return false;
+            } else {
+                if (!type->isa<DefiniteArrayType>() || num > max_dynamic_dim)
+                    return false;
+                for (auto lea_use : lea->uses()) {
+                    if (!is_access(lea_use))
+                        return false;
+                }
+            }
+        } else if (!is_access(use)) {
             return false;
         }
     }
@@ -69,30 +138,29 @@ static bool can_split(const Slot* slot) {
 }
 
 static bool split_slots(const Scope& scope) {
-    bool todo = false;
-    // TODO
-#if 0
-    for (const auto& block : schedule(scope, Schedule::Late)) {
-        for (auto primop : block) {
-            if (auto slot = primop->isa<Slot>()) {
-                if (can_split(slot)) {
-                    split(slot);
-                    todo = true;
-                }
-            }
-        }
+    std::vector<const Slot*> slots;
+    for (auto def : scope.defs()) {
+        if (auto slot = def->isa<Slot>(); slot && can_split(slot))
+            slots.emplace_back(slot);
     }
-#endif
-    return todo;
+
+    for (auto slot : slots)
+        split(slot);
+
+    return !slots.empty();
 }
 
 void split_slots(World& world) {
+    world.VLOG("start split_slots");
+    // nested aggregates are split in subsequent iterations
     bool todo = true;
     while (todo) {
         todo = false;
         Scope::for_each(world, [&] (const Scope& scope) { todo |= split_slots(scope); });
         world.cleanup();
     }
+    debug_verify(world);
+    world.VLOG("end split_slots");
 }
 
 }
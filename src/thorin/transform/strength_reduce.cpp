@@ -0,0 +1,139 @@
+#include "thorin/transform/strength_reduce.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/induction.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+
+namespace thorin {
+
+class StrengthReduce {
+public:
+    StrengthReduce(const Scope& scope)
+        : scope_(scope)
+        , ivs_(scope)
+    {}
+
+    World& world() const { return scope_.world(); }
+    bool run();
+
+private:
+    const Def* reduce(const Def* def);
+    const Param* reduced_param(const InductionVars::Loop&, const InductionVar*, const Def* scale);
+
+    struct Increment {
+        const Param* param;
+        const Def* init; ///< Passed by the preheaders.
+        const Def* next; ///< Passed by the latches.
+    };
+
+    const Scope& scope_;
+    InductionVars ivs_;
+    ParamMap<DefMap<const Param*>> reduced_;           ///< Induction variable -> scale -> reduced @p Param.
+    ContinuationMap<std::vector<Increment>> increments_; ///< Header -> new @p Param%s.
+};
+
+bool StrengthReduce::run() {
+    if (ivs_.loops().empty())
+        return false;
+
+    std::vector<const LEA*> leas;
+    for (auto def : scope_.defs()) {
+        if (auto lea = def->isa<LEA>(); lea && is_type_i(lea->index()->type()))
+            leas.push_back(lea);
+    }
+    std::sort(leas.begin(), leas.end(), [](const LEA* a, const LEA* b) { return a->gid() < b->gid(); });
+
+    size_t num_leas = 0;
+    for (auto lea : leas) {
+        auto index = reduce(lea->index());
+        if (index != lea->index()) {
+            lea->replace(world().lea(lea->ptr(), index, lea->debug()));
+            ++num_leas;
+        }
+    }
+
+    if (increments_.empty())
+        return false;
+
+    size_t num_params = 0;
+    for (const auto& loop : ivs_.loops()) {
+        auto i = increments_.find(loop.header);
+        if (i == increments_.end())
+            continue;
+
+        auto rebuild = [&](Continuation* caller, bool latch) {
+            std::vector<const Def*> args(caller->args().begin(), caller->args().end());
+            for (const auto& increment : i->second)
+                args.push_back(latch ? increment.next : increment.init);
+            caller->jump(caller->callee(), args, caller->debug());
+        };
+        for (auto preheader : loop.preheaders) rebuild(preheader, false);
+        for (auto latch     : loop.latches)    rebuild(latch,     true);
+        num_params += i->second.size();
+    }
+
+    world().ILOG("strength-reduced {} address computations with {} new induction variables in {}",
+                 num_leas, num_params, scope_.entry());
+    return true;
+}
+
+/// Rewrites @p def such that all multiplications of an @p InductionVar are replaced by additive header @p Param%s.
+const Def* StrengthReduce::reduce(const Def* def) {
+    // find the innermost loop in which def varies
+    const InductionVars::Loop* loop = nullptr;
+    for (const auto& l : ivs_.loops()) {
+        if (!ivs_.is_invariant(l, def)) {
+            loop = &l;
+            break;
+        }
+    }
+    if (loop == nullptr)
+        return def;
+
+    auto affine = ivs_.affine(*loop, def);
+    if (!affine)
+        return def;
+
+    auto offset = reduce(affine->offset);
+    auto scale = affine->scale;
+    if (scale->isa<PrimLit>() && is_one(scale)) {
+        if (offset == affine->offset)
+            return def;
+        return world().arithop_add(affine->iv->param, offset, def->debug());
+    }
+    if (is_zero(scale))
+        return offset;
+
+    return world().arithop_add(reduced_param(*loop, affine->iv, scale), offset, def->debug());
+}
+
+const Param* StrengthReduce::reduced_param(const InductionVars::Loop& loop, const InductionVar* iv, const Def* scale) {
+    if (auto param = reduced_[iv->param].lookup(scale))
+        return *param;
+
+    auto header = loop.header;
+    auto param = header->append_param(iv->param->type(), {iv->param->name() + "_sr"});
+    auto init = world().arithop_mul(scale, iv->init);
+    auto next = world().arithop_add(param, world().arithop_mul(scale, iv->step));
+    increments_[header].push_back({param, init, next});
+    return reduced_[iv->param][scale] = param;
+}
+
+void strength_reduce(World& world) {
+    world.VLOG("start strength_reduce");
+
+    bool todo = false;
+    Scope::for_each(world, [&](const Scope& scope) {
+        StrengthReduce strength_reduce(scope);
+        todo |= strength_reduce.run();
+    });
+
+    world.VLOG("end strength_reduce");
+    debug_verify(world);
+    if (todo)
+        world.cleanup();
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef THORIN_TRANSFORM_STRENGTH_REDUCE_H
+#define THORIN_TRANSFORM_STRENGTH_REDUCE_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Strength-reduces the indices of @p LEA%s within loops.
+ * An index <tt>scale * i + offset</tt> with a basic @p InductionVar @c i and a loop-invariant @c scale other than 1 is rewritten to <tt>j + offset</tt>.
+ * The new header @p Param @c j starts at <tt>scale * init</tt> and is incremented by <tt>scale * step</tt> on each back edge.
+ * This trades a multiplication per iteration for an addition; @c offset is reduced in the enclosing loops the same way.
+ */
+void strength_reduce(World&);
+
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include "thorin/transform/unroll.h"
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/induction.h"
+#include "thorin/analyses/memory_ssa.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+#include "thorin/transform/mangle.h"
+
+namespace thorin {
+
+UnrollConfig UnrollConfig::get(Target target) {
+    switch (target) {
+        case Target::CPU: return {8, 128, 2, 2};
+        // no out-of-order execution on GPUs - unroll more to expose instruction-level parallelism
+        case Target::GPU: return {16, 256, 4, 4};
+        // HLS tools unroll and pipeline loops on their own
+        case Target::HLS: return {0, 0, 1, 1};
+    }
+    THORIN_UNREACHABLE;
+}
+
+class Unroller {
+public:
+    using Loop = InductionVars::Loop;
+
+    Unroller(const Scope& scope, const UnrollConfig& config)
+        : scope_(scope)
+        , config_(config)
+        , ivs_(scope)
+    {
+        Scheduler scheduler(scope);
+        for (auto def : scope.defs()) {
+            auto primop = def->isa<PrimOp>();
+            if (primop == nullptr || !scheduler.is_live(primop))
+                continue;
+            auto continuation = scheduler.smart(primop);
+            ++sizes_[continuation];
+            if (auto memop = primop->isa<MemOp>())
+                memops_[continuation].push_back(memop);
+        }
+    }
+
+    World& world() const { return scope_.world(); }
+    bool run();
+
+private:
+    /// The @p Continuation%s of @p loop - header first.
+    std::vector<Continuation*> region(const Loop&) const;
+    /// Number of @p PrimOp%s executed per iteration of @p loop.
+    size_t size(const Loop&) const;
+    bool is_innermost(const Loop&) const;
+    ArrayRef<const MemOp*> memops(Continuation*) const;
+    void peel(const Loop&, uint64_t n);
+    bool unroll_completely(const Loop&);
+    bool unroll_partially(const Loop&);
+    bool unroll_and_jam(const Loop&);
+
+    const Scope& scope_;
+    const UnrollConfig& config_;
+    InductionVars ivs_;
+    ContinuationMap<size_t> sizes_;
+    ContinuationMap<std::vector<const MemOp*>> memops_;
+};
+
+/// Performs at most one transformation - see @p transform_in_rounds.
+bool Unroller::run() {
+    for (auto unroll : {&Unroller::unroll_completely, &Unroller::unroll_and_jam, &Unroller::unroll_partially}) {
+        for (const auto& loop : ivs_.loops()) {
+            if (!loop.header->attributes().unrolled && (this->*unroll)(loop)) {
+                loop.header->attributes().unrolled = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<Continuation*> Unroller::region(const Loop& loop) const {
+    std::vector<Continuation*> result;
+    for (auto n : ivs_.cfg().reverse_post_order()) {
+        if (ivs_.contains(loop, n->continuation()))
+            result.push_back(n->continuation());
+    }
+    assert(result.front() == loop.header);
+    return result;
+}
+
+size_t Unroller::size(const Loop& loop) const {
+    size_t result = 0;
+    for (auto continuation : region(loop)) {
+        if (auto i = sizes_.find(continuation); i != sizes_.end())
+            result += i->second;
+    }
+    return result;
+}
+
+bool Unroller::is_innermost(const Loop& loop) const {
+    for (const auto& child : loop.head->children()) {
+        if (child->isa<LoopTree<true>::Head>())
+            return false;
+    }
+    return true;
+}
+
+ArrayRef<const MemOp*> Unroller::memops(Continuation* continuation) const {
+    auto i = memops_.find(continuation);
+    return i != memops_.end() ? ArrayRef<const MemOp*>(i->second) : ArrayRef<const MemOp*>();
+}
+
+/// Peels off the first @p n iterations of @p loop by specializing its header to the counter's value in each of them.
+void Unroller::peel(const Loop& loop, uint64_t n) {
+    auto header = loop.header;
+    auto counter = ivs_.iv(loop.counter);
+    auto index = counter->param->index();
+
+    ContinuationSet known(loop.latches.begin(), loop.latches.end());
+    std::vector<Continuation*> callers(loop.preheaders.begin(), loop.preheaders.end());
+    auto value = counter->init;
+    for (uint64_t i = 0; i != n; ++i) {
+        Scope header_scope(header);
+        Array<const Def*> args(header->num_params());
+        args[index] = value;
+        auto copy = drop(header_scope, args);
+        for (auto caller : callers)
+            caller->jump(copy, caller->args().cut({index}), caller->debug());
+
+        // the back edges of this copy enter the next one
+        callers.clear();
+        for (auto use : header->copy_uses()) {
+            auto caller = use->isa_continuation();
+            if (caller != nullptr && use.index() == 0 && known.emplace(caller).second)
+                callers.push_back(caller);
+        }
+        value = world().arithop_add(value, counter->step);
+    }
+}
+
+bool Unroller::unroll_completely(const Loop& loop) {
+    if (!loop.trip_count || *loop.trip_count > config_.max_trip_count || *loop.trip_count * size(loop) > config_.max_size)
+        return false;
+
+    // the last copy takes the exit
+    peel(loop, *loop.trip_count + 1);
+    world().ILOG("unrolled loop {} completely: {} iterations", loop.header, *loop.trip_count);
+    return true;
+}
+
+bool Unroller::unroll_partially(const Loop& loop) {
+    auto factor = config_.factor;
+    if (factor < 2 || !loop.exits_at_header || !is_innermost(loop) || factor * size(loop) > config_.max_size)
+        return false;
+
+    // with the remainder peeled off, only every factor-th iteration needs the exit test
+    bool test = true;
+    uint64_t num_peeled = 0;
+    if (loop.trip_count) {
+        if (*loop.trip_count < factor)
+            return false;
+        num_peeled = *loop.trip_count % factor;
+        peel(loop, num_peeled);
+        test = false;
+    }
+
+    auto header = loop.header;
+    auto region = this->region(loop);
+    Continuation* next = header;
+    for (unsigned i = factor - 1; i != 0; --i) {
+        Def2Def old2new;
+        old2new[header] = next;
+        auto copy = header->stub();
+        for (size_t j = 0, e = header->num_params(); j != e; ++j)
+            old2new[header->param(j)] = copy->param(j);
+
+        if (test) {
+            // leave via the original header which repeats the exit test
+            auto exit = loop.exit->stub();
+            exit->jump(header, copy->params_as_defs(), loop.exit->debug());
+            old2new[loop.exit] = exit;
+        }
+
+        clone(old2new, ArrayRef<Continuation*>(region).skip_front());
+        if (test)
+            clone_body(old2new, header, copy);
+        else
+            copy->jump(old2new[loop.body], {}, header->debug());
+        next = copy;
+    }
+
+    for (auto latch : loop.latches)
+        latch->update_callee(next);
+
+    world().ILOG("unrolled loop {} by {}, peeled {} iterations", header, factor, num_peeled);
+    return true;
+}
+
+bool Unroller::unroll_and_jam(const Loop& outer) {
+    auto factor = config_.jam_factor;
+    if (factor < 2 || !outer.trip_count || *outer.trip_count < factor || factor * size(outer) > config_.max_size)
+        return false;
+
+    const Loop* inner = nullptr;
+    for (const auto& child : outer.head->children()) {
+        if (auto head = child->isa<LoopTree<true>::Head>()) {
+            if (inner != nullptr || head->num_cf_nodes() != 1)
+                return false;
+            if (inner = ivs_.loop(head->cf_nodes().front()->continuation()); inner == nullptr)
+                return false;
+        }
+    }
+    if (inner == nullptr || !is_innermost(*inner) || !inner->exits_at_header || inner->latches.size() != 1)
+        return false;
+
+    // the outer loop consists of its header, the inner loop and the code right before and after it
+    auto header = inner->header, before = outer.body, after = inner->exit;
+    if (inner->preheaders.size() != 1 || inner->preheaders.front() != before || before->callee() != header
+            || outer.latches.size() != 1 || outer.latches.front() != after || after->callee() != outer.header)
+        return false;
+
+    auto inner_region = region(*inner);
+    for (auto continuation : region(outer)) {
+        if (continuation != outer.header && continuation != before && continuation != after && !ivs_.contains(*inner, continuation))
+            return false;
+        auto callee = continuation->callee()->isa_continuation();
+        if (callee == nullptr || (callee->intrinsic() != Intrinsic::Branch && !ivs_.contains(outer, callee)))
+            return false;
+    }
+
+    // the outer header only receives memory and induction variables - so we know their values in all copies upfront
+    std::optional<size_t> outer_mem;
+    for (auto param : outer.header->params()) {
+        if (is_mem(param)) {
+            if (outer_mem) return false;
+            outer_mem = param->index();
+        } else if (ivs_.iv(param) == nullptr) {
+            return false;
+        }
+    }
+
+    // induction variables of the inner loop that do not depend on the outer loop are shared by all copies
+    std::optional<size_t> inner_mem;
+    std::vector<size_t> shared, own;
+    ParamSet shared_params;
+    for (auto param : header->params()) {
+        auto iv = ivs_.iv(param);
+        if (is_mem(param)) {
+            if (inner_mem) return false;
+            inner_mem = param->index();
+        } else if (iv != nullptr && ivs_.is_invariant(outer, iv->init) && ivs_.is_invariant(outer, iv->step)) {
+            shared.push_back(param->index());
+            shared_params.emplace(param);
+        } else {
+            own.push_back(param->index());
+        }
+    }
+    if (outer_mem.has_value() != inner_mem.has_value())
+        return false;
+
+    // all copies must leave the inner loop in the same iteration
+    std::function<bool(const Def*)> is_uniform = [&](const Def* def) {
+        if (ivs_.is_invariant(outer, def))
+            return true;
+        if (auto param = def->isa<Param>())
+            return shared_params.contains(param);
+        if (!def->isa<PrimOp>() || def->isa<MemOp>())
+            return false;
+        for (auto op : def->ops()) {
+            if (!is_uniform(op))
+                return false;
+        }
+        return true;
+    };
+    if (!is_uniform(header->arg(0)))
+        return false;
+
+    // jamming moves the loads of the inner loop across the stores after the inner loop of the preceding copies
+    if (!memops(outer.header).empty() || !memops(before).empty())
+        return false;
+    std::vector<const Load*> loads;
+    for (auto continuation : inner_region) {
+        for (auto memop : memops(continuation)) {
+            auto load = memop->isa<Load>();
+            if (load == nullptr)
+                return false;
+            loads.push_back(load);
+        }
+    }
+    if (!memops(after).empty()) {
+        MemorySSA mssa(scope_);
+        for (auto memop : memops(after)) {
+            if (memop->isa<Load>())
+                continue;
+            auto store = memop->isa<Store>();
+            if (store == nullptr)
+                return false;
+            for (auto load : loads) {
+                if (mssa.alias(store->ptr(), load->ptr()) != AliasResult::No)
+                    return false;
+            }
+        }
+    }
+
+    auto num_peeled = *outer.trip_count % factor;
+    peel(outer, num_peeled);
+
+    // values of the outer header's params in each copy
+    std::vector<Def2Def> outer2copy(factor);
+    for (auto param : outer.header->params()) {
+        if (is_mem(param))
+            continue;
+        const Def* value = param;
+        for (unsigned i = 1; i != factor; ++i)
+            outer2copy[i][param] = value = world().arithop_add(value, ivs_.iv(param)->step);
+    }
+
+    // the jammed loop receives memory and the shared induction variables once and all other params for each copy
+    std::vector<const Type*> types;
+    if (inner_mem)
+        types.push_back(header->param(*inner_mem)->type());
+    for (auto i : shared)
+        types.push_back(header->param(i)->type());
+    for (unsigned c = 0; c != factor; ++c) {
+        for (auto i : own)
+            types.push_back(header->param(i)->type());
+    }
+    auto jammed = world().continuation(world().fn_type(types), header->debug_history());
+    auto num_shared = jammed->num_params() - factor * own.size();
+
+    auto substitute = [&](Def2Def& old2new, unsigned c, const Def* mem) {
+        size_t j = inner_mem ? 1 : 0;
+        if (inner_mem)
+            old2new[header->param(*inner_mem)] = mem;
+        for (auto i : shared)
+            old2new[header->param(i)] = jammed->param(j++);
+        j = num_shared + c * own.size();
+        for (auto i : own)
+            old2new[header->param(i)] = jammed->param(j++);
+    };
+    auto mem = inner_mem ? jammed->param(0) : nullptr;
+
+    std::vector<Continuation*> exits(factor);
+    for (auto& exit : exits)
+        exit = after->stub();
+
+    // chain the copies of the inner loop's body within one iteration of the jammed loop - only the first one tests for the exit
+    auto latch = inner->latches.front();
+    std::vector<Array<const Def*>> latch_args;
+    Continuation* prev = nullptr;
+    for (unsigned c = 0; c != factor; ++c) {
+        Def2Def old2new = outer2copy[c];
+        substitute(old2new, c, c == 0 ? mem : inner_mem ? prev->arg(*inner_mem) : nullptr);
+        old2new[after] = exits[c];
+        clone(old2new, ArrayRef<Continuation*>(inner_region).skip_front());
+        if (c == 0)
+            clone_body(old2new, header, jammed);
+        else
+            prev->jump(old2new[inner->body], {}, latch->debug());
+        prev = old2new[latch]->as_continuation();
+        latch_args.emplace_back(prev->args());
+    }
+
+    Array<const Def*> args(jammed->num_params());
+    size_t j = 0;
+    if (inner_mem)
+        args[j++] = latch_args.back()[*inner_mem];
+    for (auto i : shared)
+        args[j++] = latch_args.back()[i];
+    for (unsigned c = 0; c != factor; ++c) {
+        for (auto i : own)
+            args[j++] = latch_args[c][i];
+    }
+    prev->jump(jammed, args, latch->debug());
+
+    // run the code after the inner loop for each copy in turn
+    prev = nullptr;
+    for (unsigned c = 0; c != factor; ++c) {
+        Def2Def old2new = outer2copy[c];
+        substitute(old2new, c, c == 0 ? mem : outer_mem ? prev->arg(*outer_mem) : nullptr);
+        clone_body(old2new, after, exits[c]);
+        if (prev != nullptr)
+            prev->jump(exits[c], {}, after->debug());
+        prev = exits[c];
+    }
+
+    Array<const Def*> init(jammed->num_params());
+    j = 0;
+    if (inner_mem)
+        init[j++] = before->arg(*inner_mem);
+    for (auto i : shared)
+        init[j++] = before->arg(i);
+    for (unsigned c = 0; c != factor; ++c) {
+        for (auto i : own)
+            init[j++] = instantiate(outer2copy[c], before->arg(i));
+    }
+    before->jump(jammed, init, before->debug());
+
+    jammed->attributes().unrolled = true;
+    world().ILOG("unrolled loop {} by {} and jammed the copies of loop {}, peeled {} iterations", outer.header, factor, header, num_peeled);
+    return true;
+}
+
+void unroll(World& world, const UnrollConfig& config) {
+    world.VLOG("start unroll");
+
+    // kernels are unrolled by their backend with the device's config
+    transform_in_rounds(world, [&](const Scope& scope) { return Unroller(scope, config).run(); },
+                        [] (Continuation* intrinsic) { return intrinsic->is_device_backend(); });
+
+    world.VLOG("end unroll");
+    debug_verify(world);
+}
+
+}
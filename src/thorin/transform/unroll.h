@@ -0,0 +1,39 @@
+#ifndef THORIN_TRANSFORM_UNROLL_H
+#define THORIN_TRANSFORM_UNROLL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace thorin {
+
+class World;
+enum class Target;
+
+/// Tuning knobs of @p unroll.
+struct UnrollConfig {
+    /// Loops with a known trip count of at most this are unrolled completely.
+    uint64_t max_trip_count;
+    /// Upper bound on the number of @p PrimOp%s of an unrolled loop.
+    size_t max_size;
+    /// Innermost loops are unrolled this many times; 1 disables partial unrolling.
+    unsigned factor;
+    /// Outer loops around a single innermost loop are unrolled this many times and the copies of the inner loop are jammed into one; 1 disables unroll-and-jam.
+    unsigned jam_factor;
+
+    static UnrollConfig get(Target);
+};
+
+/**
+ * Unrolls loops found by @p InductionVars according to @p config:
+ *  - Loops with a small known trip count are unrolled completely by specializing the header to the counter's value in each iteration.
+ *  - Other innermost loops that only exit at their header are unrolled @p UnrollConfig::factor times.
+ *    If the trip count is known, the remainder iterations are peeled off first so the exit test is only needed once per unrolled iteration.
+ *    Otherwise, each copy keeps its exit test.
+ *  - Loop nests whose outer loop consists of nothing but an inner loop plus the code before and after it are unrolled-and-jammed:
+ *    The copies of the inner loop run in lock-step within a single loop.
+ */
+void unroll(World&, const UnrollConfig& config);
+
+}
+
+#endif
@@ -0,0 +1,553 @@
+#include "thorin/transform/vectorize.h"
+
+#include <algorithm>
+#include <map>
+#include <optional>
+
+#include "thorin/primop.h"
+#include "thorin/world.h"
+#include "thorin/analyses/schedule.h"
+#include "thorin/analyses/scope.h"
+#include "thorin/analyses/verify.h"
+#include "thorin/transform/if_conversion.h"
+
+namespace thorin {
+
+struct VectorizeArgs {
+    enum {
+        Mem = 0,
+        Length,
+        Body,
+        Return,
+        Num
+    };
+};
+
+/// Parameters of a body passed to @c vectorize; the free variables lifted by @p lift_builtins follow.
+struct BodyParams {
+    enum {
+        Mem = 0,
+        Index,
+        Return,
+        Num
+    };
+};
+
+static int64_t literal_value(const Def* def) {
+    return is_type_s(def->type()) ? primlit_value<int64_t>(def) : int64_t(primlit_value<uint64_t>(def));
+}
+
+class Vectorizer {
+public:
+    Vectorizer(Continuation* body, size_t length)
+        : body_(body)
+        , length_(length)
+        , scope_(body)
+    {}
+
+    World& world() const { return scope_.world(); }
+    /// Why @p run failed.
+    const char* reason() const { return reason_; }
+    /// The widened body which takes the @p Param%s of the original one except the index - @c nullptr if the body is not supported.
+    Continuation* run();
+
+private:
+    /// The lanes of an integer vector form the sequence <tt>first, first + stride, ...</tt>.
+    struct Lanes {
+        const Def* first;
+        int64_t stride;
+    };
+
+    /// Pointers <tt>lea(ptr, index)</tt> with a varying @c index - only allowed as address of a @p Load or @p Store.
+    struct Address {
+        const Def* ptr;
+        const Def* index;
+    };
+
+    bool check();
+    bool fail(const char* reason) { reason_ = reason; return false; }
+    static bool is_varying(const Type* type) { auto vector_type = type->isa<VectorType>(); return vector_type != nullptr && vector_type->is_vector(); }
+    static bool is_varying(const Def* def) { return is_varying(def->type()); }
+    const Type* widen(const Type* type);
+    const Def* splat(const Def* def) { return is_varying(def) ? def : world().splat(def, length_, def->debug()); }
+    std::optional<Lanes> lanes(const Def* def) const;
+    const Def* widen(const Def* odef);
+    const Def* widen(const PrimOp* oprimop, Defs nops);
+    const Def* access(const Access* oaccess, Defs nops);
+    Continuation* block(Continuation* ocontinuation);
+    Continuation* target(Continuation* ocontinuation);
+    bool emit(Continuation* ocontinuation, Continuation* ncontinuation);
+    bool diverge(Continuation* ocontinuation, Continuation* ncontinuation, const Def* cond);
+
+    Continuation* body_;
+    size_t length_;
+    Scope scope_;
+    const char* reason_ = nullptr;
+    ContinuationMap<std::vector<const PrimOp*>> schedule_;
+    Def2Def old2new_;
+    DefMap<Lanes> lanes_;
+    DefMap<Address> addresses_;
+    ContinuationMap<Continuation*> blocks_;
+    ContinuationSet flattened_;
+    ContinuationMap<std::vector<std::pair<Continuation*, Array<const Def*>>>> incoming_;
+};
+
+bool Vectorizer::check() {
+    for (auto def : scope_.defs()) {
+        if (is_varying(def))
+            return fail("the body already uses vectors");
+    }
+
+    auto& cfg = scope_.f_cfg();
+    for (auto n : cfg.reverse_post_order()) {
+        for (auto succ : cfg.succs(n)) {
+            if (F_CFG::index(succ) <= F_CFG::index(n))
+                return fail("the body contains a loop");
+        }
+
+        auto continuation = n->continuation();
+        if (continuation->intrinsic() == Intrinsic::EndScope)
+            continue;
+        if (continuation != body_ && !continuation->is_basicblock())
+            return fail("the body contains a higher-order continuation");
+
+        auto callee = continuation->callee();
+        if (callee == body_->param(BodyParams::Return))
+            continue;
+        if (auto target = callee->isa_continuation()) {
+            if (target->intrinsic() == Intrinsic::Branch || (!target->is_intrinsic() && scope_.contains(target)))
+                continue;
+        }
+        return fail("the body calls a function");
+    }
+
+    Scheduler scheduler(scope_);
+    for (auto def : scope_.defs()) {
+        if (auto primop = def->isa<PrimOp>(); primop && scheduler.is_live(primop))
+            schedule_[scheduler.late(primop)].push_back(primop);
+    }
+    return true;
+}
+
+const Type* Vectorizer::widen(const Type* type) {
+    if (auto prim_type = type->isa<PrimType>())
+        return world().prim_type(prim_type->primtype_tag(), length_);
+    return nullptr;
+}
+
+std::optional<Vectorizer::Lanes> Vectorizer::lanes(const Def* def) const {
+    if (!is_varying(def))
+        return Lanes{def, 0};
+    if (auto lanes = lanes_.lookup(def))
+        return *lanes;
+    return std::nullopt;
+}
+
+Continuation* Vectorizer::run() {
+    if (!check())
+        return nullptr;
+
+    std::vector<const Type*> types;
+    for (auto param : body_->params()) {
+        if (param->index() != BodyParams::Index)
+            types.push_back(param->type());
+    }
+    auto entry = world().continuation(world().fn_type(types), {body_->name() + "_vectorized"});
+
+    for (size_t i = 0, j = 0, e = body_->num_params(); i != e; ++i) {
+        auto param = body_->param(i);
+        if (i == BodyParams::Index) {
+            Array<const Def*> lanes(length_, [&](size_t lane) { return world().cast(param->type(), world().literal_qu64(lane, {})); });
+            auto index = world().vector(lanes, param->debug());
+            lanes_[index] = {world().zero(param->type()), 1};
+            old2new_[param] = index;
+        } else {
+            old2new_[param] = entry->param(j);
+            entry->param(j++)->set_name(param->name());
+        }
+    }
+    blocks_[body_] = entry;
+
+    for (auto n : scope_.f_cfg().reverse_post_order()) {
+        auto ocontinuation = n->continuation();
+        if (ocontinuation->intrinsic() == Intrinsic::EndScope || flattened_.contains(ocontinuation))
+            continue;
+        auto ncontinuation = block(ocontinuation);
+        if (ncontinuation == nullptr || !emit(ocontinuation, ncontinuation))
+            return nullptr;
+    }
+
+    return entry;
+}
+
+/// The new block of @p ocontinuation - blocks with @p Param%s are created once all their predecessors have been emitted.
+Continuation* Vectorizer::block(Continuation* ocontinuation) {
+    if (auto ncontinuation = blocks_.lookup(ocontinuation))
+        return *ncontinuation;
+
+    auto& incoming = incoming_[ocontinuation];
+    Array<const Type*> types(ocontinuation->num_params(), [&](size_t i) { return ocontinuation->param(i)->type(); });
+    for (auto& [pred, args] : incoming) {
+        for (size_t i = 0, e = args.size(); i != e; ++i) {
+            if (is_varying(args[i]) && !is_varying(types[i]) && (types[i] = widen(types[i])) == nullptr) {
+                fail("the body passes a varying aggregate");
+                return nullptr;
+            }
+        }
+    }
+
+    auto ncontinuation = world().continuation(world().fn_type(types), ocontinuation->debug_history());
+    for (size_t i = 0, e = ocontinuation->num_params(); i != e; ++i)
+        old2new_[ocontinuation->param(i)] = ncontinuation->param(i);
+
+    for (auto& [pred, args] : incoming) {
+        Array<const Def*> nargs(args.size(), [&](size_t i) { return is_varying(ncontinuation->param(i)) ? splat(args[i]) : args[i]; });
+        pred->jump(ncontinuation, nargs, pred->debug());
+    }
+    return blocks_[ocontinuation] = ncontinuation;
+}
+
+/// The new block of @p ocontinuation which is entered without arguments.
+Continuation* Vectorizer::target(Continuation* ocontinuation) {
+    if (auto ncontinuation = blocks_.lookup(ocontinuation))
+        return *ncontinuation;
+    assert(ocontinuation->num_params() == 0);
+    return blocks_[ocontinuation] = world().continuation(world().fn_type(), ocontinuation->debug_history());
+}
+
+bool Vectorizer::emit(Continuation* ocontinuation, Continuation* ncontinuation) {
+    Array<const Def*> nargs(ocontinuation->num_args());
+    for (size_t i = 0, e = nargs.size(); i != e; ++i) {
+        if (ocontinuation->arg(i)->isa_continuation())
+            continue; // branch targets
+        if ((nargs[i] = widen(ocontinuation->arg(i))) == nullptr)
+            return false;
+    }
+
+    auto callee = ocontinuation->callee();
+    if (callee == body_->param(BodyParams::Return)) {
+        for (auto arg : nargs) {
+            if (is_varying(arg))
+                return fail("the body returns a varying value");
+        }
+        ncontinuation->jump(old2new_[callee], nargs, ocontinuation->debug());
+        return true;
+    }
+
+    auto ocallee = callee->as_continuation();
+    if (ocallee->intrinsic() == Intrinsic::Branch) {
+        auto cond = nargs[0];
+        if (is_varying(cond))
+            return diverge(ocontinuation, ncontinuation, cond);
+        auto t = ocontinuation->arg(1)->as_continuation(), f = ocontinuation->arg(2)->as_continuation();
+        ncontinuation->branch(cond, target(t), target(f), ocontinuation->debug());
+        return true;
+    }
+
+    if (ocallee->num_params() == 0)
+        ncontinuation->jump(target(ocallee), {}, ocontinuation->debug());
+    else
+        incoming_[ocallee].emplace_back(ncontinuation, nargs);
+    return true;
+}
+
+/// Flattens the diamond below the @c branch of @p ocontinuation on the varying @p cond into @p ncontinuation.
+bool Vectorizer::diverge(Continuation* ocontinuation, Continuation* ncontinuation, const Def* cond) {
+    auto t = ocontinuation->arg(1)->as_continuation(), f = ocontinuation->arg(2)->as_continuation();
+    if (t == f)
+        return fail("the body contains a degenerated branch");
+    for (auto arm : {t, f}) {
+        if (arm->num_uses() != 1)
+            return fail("a varying branch does not form a diamond");
+    }
+
+    auto join = t->callee()->isa_continuation();
+    if (join == nullptr || join != f->callee() || join->is_intrinsic() || join->num_uses() != 2)
+        return fail("a varying branch does not form a diamond");
+
+    for (auto arm : {t, f}) {
+        if (auto i = schedule_.find(arm); i != schedule_.end()) {
+            for (auto primop : i->second) {
+                if (!is_speculatable(primop))
+                    return fail("a varying branch guards side effects");
+            }
+        }
+        flattened_.emplace(arm);
+    }
+
+    // loads before the branch stay on the chain: a store after the join must not overtake them
+    auto within_arms = [&](const Load* load) {
+        for (auto arm : {t, f}) {
+            if (auto i = schedule_.find(arm); i != schedule_.end() && std::find(i->second.begin(), i->second.end(), load) != i->second.end())
+                return true;
+        }
+        return false;
+    };
+    for (size_t i = 0, e = join->num_params(); i != e; ++i) {
+        auto a = widen(t->arg(i)), b = widen(f->arg(i));
+        if (a == nullptr || b == nullptr)
+            return false;
+
+        const Def* value;
+        if (a == b) {
+            value = a;
+        } else if (is_mem(a)) {
+            // the schedule refers to the original loads
+            auto mem = skip_loads(t->arg(i), within_arms);
+            if (mem != skip_loads(f->arg(i), within_arms))
+                return fail("a varying branch guards side effects");
+            value = widen(mem);
+        } else {
+            if (widen(a->type()) == nullptr)
+                return fail("the body selects a varying aggregate");
+            value = world().select(cond, splat(a), splat(b), join->param(i)->debug());
+        }
+        old2new_[join->param(i)] = value;
+    }
+
+    blocks_[join] = ncontinuation;
+    return true;
+}
+
+const Def* Vectorizer::widen(const Def* odef) {
+    if (auto ndef = old2new_.lookup(odef))
+        return *ndef;
+
+    post_order_walk(odef,
+        [&](const Def* def) {
+            if (reason_ != nullptr || old2new_.contains(def))
+                return false;
+            if (!scope_.contains(def)) {
+                old2new_[def] = def;
+                return false;
+            }
+            if (def->isa<PrimOp>())
+                return true;
+            fail("the body uses a continuation as value");
+            return false;
+        },
+        [&](const Def* def) { return def->ops(); },
+        [&](const Def* def) {
+            if (reason_ != nullptr)
+                return;
+
+            auto oprimop = def->as<PrimOp>();
+            Array<const Def*> nops(oprimop->num_ops());
+            bool varying = false;
+            for (size_t i = 0, e = nops.size(); i != e; ++i) {
+                auto op = oprimop->op(i);
+                if (addresses_.contains(op) && (i != 1 || !oprimop->isa<Access>())) {
+                    fail("the body uses a varying pointer other than for loading or storing");
+                    return;
+                }
+                nops[i] = old2new_[op];
+                varying |= is_varying(nops[i]);
+            }
+
+            const Def* ndef;
+            if (auto oaccess = oprimop->isa<Access>(); oaccess && addresses_.contains(oaccess->ptr()))
+                ndef = access(oaccess, nops);
+            else if (varying)
+                ndef = widen(oprimop, nops);
+            else
+                ndef = oprimop->rebuild(world(), oprimop->type(), nops);
+
+            if (ndef != nullptr)
+                old2new_[oprimop] = ndef;
+        });
+
+    return reason_ == nullptr ? old2new_[odef] : nullptr;
+}
+
+/// Rebuilds @p oprimop with the new operands @p nops of which at least one is varying.
+const Def* Vectorizer::widen(const PrimOp* oprimop, Defs nops) {
+    auto dbg = oprimop->debug();
+
+    if (auto lea = oprimop->isa<LEA>()) {
+        if (is_varying(nops[0]) || !lea->ptr_pointee()->isa<ArrayType>()) {
+            fail("the body computes a varying pointer");
+            return nullptr;
+        }
+        // stays as is - the accesses via this pointer are widened instead
+        addresses_[lea] = {nops[0], nops[1]};
+        return lea;
+    }
+
+    if (auto arithop = oprimop->isa<ArithOp>()) {
+        auto result = world().arithop(arithop->arithop_tag(), splat(nops[0]), splat(nops[1]), dbg);
+        auto a = lanes(nops[0]), b = lanes(nops[1]);
+        if (result->isa<PrimLit>() || !is_type_i(result->type()) || !a || !b)
+            return result;
+
+        auto first = world().arithop(arithop->arithop_tag(), a->first, b->first, dbg);
+        switch (arithop->arithop_tag()) {
+            case ArithOp_add: lanes_[result] = {first, a->stride + b->stride}; break;
+            case ArithOp_sub: lanes_[result] = {first, a->stride - b->stride}; break;
+            case ArithOp_mul:
+                if (b->stride == 0 && b->first->isa<PrimLit>())
+                    lanes_[result] = {first, a->stride * literal_value(b->first)};
+                else if (a->stride == 0 && a->first->isa<PrimLit>())
+                    lanes_[result] = {first, b->stride * literal_value(a->first)};
+                break;
+            case ArithOp_shl:
+                if (b->stride == 0 && b->first->isa<PrimLit>())
+                    lanes_[result] = {first, a->stride << literal_value(b->first)};
+                break;
+            default:
+                break;
+        }
+        return result;
+    }
+
+    if (auto cmp = oprimop->isa<Cmp>())
+        return world().cmp(cmp->cmp_tag(), splat(nops[0]), splat(nops[1]), dbg);
+
+    if (auto mathop = oprimop->isa<MathOp>()) {
+        Array<const Def*> args(nops.size(), [&](size_t i) { return splat(nops[i]); });
+        return world().mathop(mathop->mathop_tag(), args, dbg);
+    }
+
+    if (oprimop->isa<Select>()) {
+        if (widen(nops[1]->type()) == nullptr) {
+            fail("the body selects a varying aggregate");
+            return nullptr;
+        }
+        return world().select(splat(nops[0]), splat(nops[1]), splat(nops[2]), dbg);
+    }
+
+    if (oprimop->isa<ConvOp>()) {
+        auto type = widen(oprimop->type());
+        if (type == nullptr) {
+            fail("the body converts a varying value to an aggregate");
+            return nullptr;
+        }
+        if (oprimop->isa<Bitcast>())
+            return world().bitcast(type, nops[0], dbg);
+
+        auto result = world().cast(type, nops[0], dbg);
+        if (auto a = lanes(nops[0]); a && is_type_i(nops[0]->type()) && is_type_i(type))
+            lanes_[result] = {world().cast(oprimop->type(), a->first, dbg), a->stride};
+        return result;
+    }
+
+    fail("the body contains an operation which cannot be widened");
+    return nullptr;
+}
+
+/// Widens the @p Load or @p Store @p oaccess via a varying @p Address.
+const Def* Vectorizer::access(const Access* oaccess, Defs nops) {
+    auto dbg = oaccess->debug();
+    auto address = addresses_[oaccess->ptr()];
+    auto ptr_type = oaccess->ptr()->type()->as<PtrType>();
+    auto vector_type = widen(ptr_type->pointee());
+    if (vector_type == nullptr) {
+        fail("the body accesses varying aggregates");
+        return nullptr;
+    }
+
+    auto mem = nops[0];
+    if (auto lanes = this->lanes(address.index); lanes && lanes->stride == 1) {
+        // consecutive elements
+        auto vector_ptr_type = world().ptr_type(vector_type, 1, ptr_type->device(), ptr_type->addr_space());
+        auto ptr = world().bitcast(vector_ptr_type, world().lea(address.ptr, lanes->first, dbg), dbg);
+        if (oaccess->isa<Load>())
+            return world().load(mem, ptr, dbg);
+        return world().store(mem, ptr, splat(nops[2]), dbg);
+    }
+
+    // gather or scatter lane by lane
+    Array<const Def*> vals(length_);
+    for (size_t i = 0; i != length_; ++i) {
+        auto ptr = world().lea(address.ptr, world().extract(address.index, u32(i), dbg), dbg);
+        if (oaccess->isa<Load>()) {
+            auto load = world().load(mem, ptr, dbg);
+            mem = world().extract(load, 0_s, dbg);
+            vals[i] = world().extract(load, 1, dbg);
+        } else {
+            auto val = nops[2];
+            mem = world().store(mem, ptr, is_varying(val) ? world().extract(val, u32(i), dbg) : val, dbg);
+        }
+    }
+
+    if (oaccess->isa<Load>())
+        return world().tuple({mem, world().vector(vals, dbg)}, dbg);
+    return mem;
+}
+
+/// Replaces the @c vectorize call of @p call by a loop which calls the @p body for each lane.
+static void serialize(Continuation* call, Continuation* body, const Def* length) {
+    auto& world = call->world();
+    auto index_type = body->param(BodyParams::Index)->type();
+    auto mem_type = world.mem_type();
+    auto dbg = call->debug();
+
+    auto head = world.continuation(world.fn_type({mem_type, index_type}), {"vectorize_head"});
+    auto lane = world.continuation(world.fn_type(), {"vectorize_lane"});
+    auto next = world.continuation(world.fn_type({mem_type}), {"vectorize_next"});
+    auto exit = world.continuation(world.fn_type(), {"vectorize_exit"});
+
+    Array<const Def*> args(body->num_params());
+    args[BodyParams::Mem]    = head->param(0);
+    args[BodyParams::Index]  = head->param(1);
+    args[BodyParams::Return] = next;
+    for (size_t i = BodyParams::Num, e = args.size(); i != e; ++i)
+        args[i] = call->arg(i - BodyParams::Num + VectorizeArgs::Num);
+
+    auto ret = call->arg(VectorizeArgs::Return);
+    call->jump(head, {call->arg(VectorizeArgs::Mem), world.zero(index_type)}, dbg);
+    head->branch(world.cmp_lt(head->param(1), world.cast(index_type, length)), lane, exit, dbg);
+    lane->jump(body, args, dbg);
+    next->jump(head, {next->param(0), world.arithop_add(head->param(1), world.one(index_type))}, dbg);
+    exit->jump(ret, {head->param(0)}, dbg);
+}
+
+void vectorize(World& world) {
+    world.VLOG("start vectorize");
+
+    std::vector<Continuation*> calls;
+    for (auto continuation : world.continuations()) {
+        if (auto callee = continuation->callee()->isa_continuation(); callee && callee->intrinsic() == Intrinsic::Vectorize)
+            calls.push_back(continuation);
+    }
+
+    std::map<std::pair<Continuation*, u32>, Continuation*> vectorized;
+    for (auto call : calls) {
+        auto global = call->num_args() >= VectorizeArgs::Num ? call->arg(VectorizeArgs::Body)->isa<Global>() : nullptr;
+        auto body = global != nullptr ? global->init()->isa_continuation() : nullptr;
+        if (body == nullptr || body->num_params() != call->num_args() - VectorizeArgs::Num + BodyParams::Num || !is_type_i(body->param(BodyParams::Index)->type())) {
+            world.WLOG("cannot lower vectorize call in {}", call);
+            continue;
+        }
+
+        auto length = call->arg(VectorizeArgs::Length);
+        if (!length->isa<PrimLit>())
+            world.edef(length, "vector length must be known at compile-time");
+
+        auto num_lanes = primlit_value<u32>(length);
+        auto& simd = vectorized[{body, num_lanes}];
+        if (simd == nullptr && num_lanes > 1) {
+            Vectorizer vectorizer(body, num_lanes);
+            simd = vectorizer.run();
+            if (simd != nullptr)
+                world.ILOG("vectorized {} with {} lanes", body, num_lanes);
+            else
+                world.WLOG("cannot vectorize {} since {}; running its {} lanes one after another", body, vectorizer.reason(), num_lanes);
+        }
+
+        if (simd != nullptr) {
+            Array<const Def*> args(simd->num_params());
+            args[0] = call->arg(VectorizeArgs::Mem);
+            args[1] = call->arg(VectorizeArgs::Return);
+            for (size_t i = 2, e = args.size(); i != e; ++i)
+                args[i] = call->arg(i - 2 + VectorizeArgs::Num);
+            call->jump(simd, args, call->debug());
+        } else {
+            serialize(call, body, length);
+        }
+    }
+
+    world.VLOG("end vectorize");
+    debug_verify(world);
+}
+
+}
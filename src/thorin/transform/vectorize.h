@@ -0,0 +1,20 @@
+#ifndef THORIN_TRANSFORM_VECTORIZE_H
+#define THORIN_TRANSFORM_VECTORIZE_H
+
+namespace thorin {
+
+class World;
+
+/**
+ * Lowers the calls to the @c vectorize intrinsic without RV.
+ * The body is widened to a single function which runs all lanes at once:
+ *  - Values depending on the lane index become @p PrimType%s of the vector length.
+ *  - Branches on such values are turned into @p Select%s with the condition as mask - the arms must only compute values that are safe to speculate.
+ *  - @p Load%s and @p Store%s whose @p LEA index depends on the lane index access consecutive elements as a whole vector or gather/scatter the elements lane by lane.
+ * Bodies with loops, calls or other unsupported constructs run their lanes one after another instead.
+ */
+void vectorize(World&);
+
+}
+
+#endif
@@ -59,6 +59,7 @@ const NominalType* StructType::stub(TypeTable& to) const {
 const NominalType* VariantType::stub(TypeTable& to) const {
     auto type = to.variant_type(name(), num_ops());
     std::copy(op_names_.begin(), op_names_.end(), type->op_names().begin());
+    type->set_nonnull(is_nonnull());
     return type;
 }
 
@@ -90,6 +91,26 @@ bool VariantType::has_payload() const {
     return !std::all_of(ops().begin(), ops().end(), is_type_unit);
 }
 
+size_t VariantType::tag_bits() const {
+    return num_ops() < (1_u64 <<  8) ?  8 :
+           num_ops() < (1_u64 << 16) ? 16 :
+           num_ops() < (1_u64 << 32) ? 32 : 64;
+}
+
+std::optional<size_t> VariantType::nullable_ptr() const {
+    // a pointer may well be null - e.g. after an int to pointer cast or when returned by a foreign function
+    if (!is_nonnull() || num_ops() != 2)
+        return std::nullopt;
+    for (size_t i = 0; i != 2; ++i) {
+        // the null pointer is a valid address in the other address spaces of some targets
+        auto ptr_type = op(i)->isa<PtrType>();
+        if (ptr_type != nullptr && !ptr_type->is_vector() && is_type_unit(op(1 - i))
+            && (ptr_type->addr_space() == AddrSpace::Generic || ptr_type->addr_space() == AddrSpace::Global))
+            return i;
+    }
+    return std::nullopt;
+}
+
 bool use_lea(const Type* type) { return type->isa<StructType>() || type->isa<ArrayType>(); }
 
 //------------------------------------------------------------------------------
@@ -153,7 +174,7 @@ Stream& Type::stream(Stream& s) const {
     } else if (auto t = isa<StructType>()) {
         return s.fmt("struct {}", t->name());
     } else if (auto t = isa<VariantType>()) {
-        return s.fmt("variant {}", t->name());
+        return s.fmt(t->is_nonnull() ? "variant nonnull {}" : "variant {}", t->name());
     } else if (auto t = isa<TupleType>()) {
         return s.fmt("[{, }]", t->ops());
     } else if (auto t = isa<PtrType>()) {
@@ -1,6 +1,8 @@
 #ifndef THORIN_TYPE_H
 #define THORIN_TYPE_H
 
+#include <optional>
+
 #include "thorin/enums.h"
 #include "thorin/util/hash.h"
 #include "thorin/util/cast.h"
@@ -136,6 +138,22 @@ public:
     const NominalType* stub(TypeTable&) const override;
 
     bool has_payload() const;
+    /// Number of bits of the smallest integer type able to hold the tag - at least one byte.
+    size_t tag_bits() const;
+    /**
+     * Frontends opt in by setting this if no pointer stored in this type is ever @c nullptr - e.g. for references.
+     * @p stub keeps it, so it survives the @p Importer.
+     */
+    bool is_nonnull() const { return nonnull_; }
+    void set_nonnull(bool nonnull) const { const_cast<VariantType*>(this)->nonnull_ = nonnull; }
+    /**
+     * If this type is @p is_nonnull and consists of exactly one pointer alternative and one unit alternative, the index of the pointer alternative.
+     * The backends then lay this type out as the pointer alone and use @c nullptr to encode the unit alternative instead of a separate tag.
+     */
+    std::optional<size_t> nullable_ptr() const;
+
+private:
+    bool nonnull_ = false;
 
     friend class TypeTable;
 };
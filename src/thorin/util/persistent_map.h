@@ -0,0 +1,137 @@
+#ifndef THORIN_UTIL_PERSISTENT_MAP_H
+#define THORIN_UTIL_PERSISTENT_MAP_H
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "thorin/util/hash.h"
+#include "thorin/util/utility.h"
+
+namespace thorin {
+
+/**
+ * A persistent map implemented as hash array mapped trie (HAMT).
+ * Copying a @p PersistentMap is O(1) as all copies share their nodes.
+ * @p set only copies the path from the root to the modified leaf which is O(log_32 n).
+ * Thus, forking a map and updating both copies independently is cheap.
+ * @p H has to provide @c H::hash(key) and @c H::eq(a, b) - just like for @p HashMap.
+ */
+template<class Key, class Value, class H>
+class PersistentMap {
+private:
+    static constexpr size_t bits = 5;
+    static constexpr hash_t mask = (hash_t(1) << bits) - hash_t(1);
+
+    struct Node {
+        bool is_leaf() const { return !entries.empty(); }
+
+        hash_t hash = 0;                                    ///< Only valid for leaves.
+        std::vector<std::pair<Key, Value>> entries;         ///< Leaf: all entries with @p hash (collisions).
+        uint32_t bitmap = 0;                                ///< Branch: which of the 32 children are present.
+        std::vector<std::shared_ptr<const Node>> children;  ///< Branch: the present children.
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+public:
+    PersistentMap() = default;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    std::optional<Value> lookup(const Key& key) const {
+        if (auto value = find(key)) return *value;
+        return std::nullopt;
+    }
+
+    /// Maps @p key to @p value; other copies of this map are not affected.
+    void set(const Key& key, const Value& value) {
+        bool added = false;
+        root_ = set(root_, H::hash(key), 0, key, value, added);
+        if (added) ++size_;
+    }
+
+private:
+    static size_t child_index(uint32_t bitmap, uint32_t bit) { return bitcount(bitmap & (bit - 1_u32)); }
+    static uint32_t bit_of(hash_t hash, size_t shift) { return 1_u32 << ((hash >> shift) & mask); }
+
+    const Value* find(const Key& key) const {
+        auto hash = H::hash(key);
+        const Node* node = root_.get();
+        for (size_t shift = 0; node != nullptr; shift += bits) {
+            if (node->is_leaf()) {
+                if (node->hash == hash) {
+                    for (const auto& [k, v] : node->entries) {
+                        if (H::eq(k, key)) return &v;
+                    }
+                }
+                return nullptr;
+            }
+
+            auto bit = bit_of(hash, shift);
+            if ((node->bitmap & bit) == 0) return nullptr;
+            node = node->children[child_index(node->bitmap, bit)].get();
+        }
+        return nullptr;
+    }
+
+    static NodePtr leaf(hash_t hash, const Key& key, const Value& value) {
+        auto node = std::make_shared<Node>();
+        node->hash = hash;
+        node->entries.emplace_back(key, value);
+        return node;
+    }
+
+    // recursion depth is bounded by the number of bits in hash_t
+    static NodePtr set(const NodePtr& node, hash_t hash, size_t shift, const Key& key, const Value& value, bool& added) {
+        if (!node) {
+            added = true;
+            return leaf(hash, key, value);
+        }
+
+        if (node->is_leaf()) {
+            if (node->hash == hash) {
+                auto copy = std::make_shared<Node>(*node);
+                for (auto& entry : copy->entries) {
+                    if (H::eq(entry.first, key)) {
+                        entry.second = value;
+                        return copy;
+                    }
+                }
+                added = true;
+                copy->entries.emplace_back(key, value);
+                return copy;
+            }
+
+            // push the old leaf one level down and retry
+            auto branch = std::make_shared<Node>();
+            branch->bitmap = bit_of(node->hash, shift);
+            branch->children.emplace_back(node);
+            return set(branch, hash, shift, key, value, added);
+        }
+
+        auto copy = std::make_shared<Node>(*node);
+        auto bit = bit_of(hash, shift);
+        auto i = child_index(copy->bitmap, bit);
+        if (copy->bitmap & bit) {
+            copy->children[i] = set(copy->children[i], hash, shift + bits, key, value, added);
+        } else {
+            added = true;
+            copy->bitmap |= bit;
+            copy->children.insert(copy->children.begin() + i, leaf(hash, key, value));
+        }
+        return copy;
+    }
+
+    NodePtr root_;
+    size_t size_ = 0;
+};
+
+template<class Key, class Value>
+using PersistentGIDMap = PersistentMap<Key, Value, GIDHash<Key>>;
+
+}
+
+#endif
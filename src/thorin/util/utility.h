@@ -2,9 +2,12 @@
 #define THORIN_UTILITY_H
 
 #include <cassert>
+#include <deque>
+#include <iterator>
 #include <memory>
 #include <stack>
 #include <queue>
+#include <utility>
 
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -128,6 +131,53 @@ private:
     std::queue<T> queue_;
 };
 
+/**
+ * Visits the graph reachable from @p root in post-order without recursing on the native stack.
+ * Thus, the required stack depth does not depend on the size of the graph.
+ * - @p enter(n) is invoked for @p root and for each edge to @p n; return @c true iff @p n should be visited now.
+ *   This is the place to check and update your visited map - it is also the place to cut cycles.
+ * - @p succs(n) yields the successors of @p n - either by value or as reference which stays valid until @p n is left.
+ * - @p leave(n) is invoked after all successors of @p n have been left.
+ */
+template<class T, class Enter, class Succs, class Leave>
+void post_order_walk(T root, Enter&& enter, Succs&& succs, Leave&& leave) {
+    using Range = decltype(succs(root));
+    using Iter  = decltype(std::begin(std::declval<Range&>()));
+
+    struct Frame {
+        Frame(T node, Range&& range)
+            : node(node)
+            , range(std::forward<Range>(range))
+            , cur(std::begin(this->range))
+            , end(std::end(this->range))
+        {}
+
+        T node;
+        Range range;
+        Iter cur;
+        Iter end;
+    };
+
+    if (!enter(root)) return;
+
+    // a deque never moves its elements when growing at the back - iterators into by-value ranges stay valid
+    std::deque<Frame> stack;
+    stack.emplace_back(root, succs(root));
+
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        if (frame.cur != frame.end) {
+            T succ = *frame.cur++;
+            if (enter(succ))
+                stack.emplace_back(succ, succs(succ));
+        } else {
+            T node = frame.node;
+            stack.pop_back();
+            leave(node);
+        }
+    }
+}
+
 template<class T>
 struct Push {
     Push(T& t, T new_val)
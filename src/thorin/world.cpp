@@ -20,13 +20,30 @@
 #include "thorin/transform/clone_bodies.h"
 #include "thorin/transform/closure_conversion.h"
 #include "thorin/transform/codegen_prepare.h"
+#include "thorin/transform/color_slots.h"
 #include "thorin/transform/dead_load_opt.h"
+#include "thorin/transform/dead_store_elim.h"
+#include "thorin/transform/dedup_kernels.h"
+#include "thorin/transform/defunctionalize.h"
 #include "thorin/transform/flatten_tuples.h"
+#include "thorin/transform/fuse_parallel.h"
 #include "thorin/transform/hoist_enters.h"
+#include "thorin/transform/hoist_loads.h"
+#include "thorin/transform/if_conversion.h"
 #include "thorin/transform/inliner.h"
 #include "thorin/transform/lift_builtins.h"
+#include "thorin/transform/merge_functions.h"
+#include "thorin/transform/parallelize.h"
 #include "thorin/transform/partial_evaluation.h"
+#include "thorin/transform/promote_allocs.h"
+#include "thorin/transform/reorder_fields.h"
+#include "thorin/transform/sccp.h"
+#include "thorin/transform/slp_vectorize.h"
+#include "thorin/transform/split_effects.h"
 #include "thorin/transform/split_slots.h"
+#include "thorin/transform/strength_reduce.h"
+#include "thorin/transform/unroll.h"
+#include "thorin/transform/vectorize.h"
 #include "thorin/util/array.h"
 
 #if (defined(__clang__) || defined(__GNUC__)) && (defined(__x86_64__) || defined(__i386__))
@@ -1039,6 +1056,17 @@ const Def* World::enter(const Def* mem, Debug dbg) {
     return cse(new Enter(mem, dbg));
 }
 
+const Def* World::join(Defs mems, Debug dbg) {
+    std::vector<const Def*> ops;
+    for (auto mem : mems) {
+        if (std::find(ops.begin(), ops.end(), mem) == ops.end())
+            ops.push_back(mem);
+    }
+    if (ops.size() == 1)
+        return ops.front();
+    return cse(new Join(ops, dbg));
+}
+
 const Def* World::alloc(const Type* type, const Def* mem, const Def* extra, Debug dbg) {
     return cse(new Alloc(type, mem, extra, dbg));
 }
@@ -1241,17 +1269,38 @@ const Def* World::cse_base(const PrimOp* primop) {
 
 void World::cleanup() { cleanup_world(*this); }
 
-void World::opt() {
+void World::opt(Target target) {
+    join_effects(*this);
     cleanup();
     while (partial_evaluation(*this, true)); // lower2cff
     flatten_tuples(*this);
+    merge_functions(*this);
+    sccp(*this);
     clone_bodies(*this);
     split_slots(*this);
     closure_conversion(*this);
+    defunctionalize(*this);
     lift_builtins(*this);
+    dedup_kernels(*this);
     inliner(*this);
+    promote_allocs(*this);
     hoist_enters(*this);
     dead_load_opt(*this);
+    hoist_loads(*this);
+    dead_store_elim(*this);
+    if (parallelize(*this, ParallelConfig::get(target)))
+        lift_builtins(*this);
+    fuse_parallel(*this);
+    if_conversion(*this, IfConversionConfig::get(target));
+    unroll(*this, UnrollConfig::get(target));
+#if !THORIN_ENABLE_RV
+    vectorize(*this);
+#endif
+    strength_reduce(*this);
+    split_effects(*this);
+    slp_vectorize(*this, SLPConfig::get(target));
+    reorder_fields(*this);
+    color_slots(*this);
     cleanup();
     codegen_prepare(*this);
 }
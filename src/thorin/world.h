@@ -18,6 +18,9 @@ namespace thorin {
 
 enum class LogLevel { Debug, Verbose, Info, Warn, Error };
 
+/// The kind of hardware a @p World is compiled for - selects target-specific tuning in @p World::opt.
+enum class Target { CPU, GPU, HLS };
+
 /**
  * The World represents the whole program and manages creation and destruction of Thorin nodes.
  * In particular, the following things are done by this class:
@@ -194,6 +197,7 @@ public:
     const Def* load(const Def* mem, const Def* ptr, Debug dbg = {});
     const Def* store(const Def* mem, const Def* ptr, const Def* val, Debug dbg = {});
     const Def* enter(const Def* mem, Debug dbg = {});
+    const Def* join(Defs mems, Debug dbg = {});
     const Def* slot(const Type* type, const Def* frame, Debug dbg = {}) { return cse(new Slot(type, frame, dbg)); }
     const Def* alloc(const Type* type, const Def* mem, const Def* extra, Debug dbg = {});
     const Def* alloc(const Type* type, const Def* mem, Debug dbg = {}) { return alloc(type, mem, literal_qu64(0, dbg), dbg); }
@@ -224,7 +228,7 @@ public:
 
     /// Performs dead code, unreachable code and unused type elimination.
     void cleanup();
-    void opt();
+    void opt(Target target = Target::CPU);
 
     // getters
 